@@ -0,0 +1,28 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <ps4.h>
+#include "../../include/proc.h"
+
+struct bench_map {
+    char name[32];
+    uint64_t start;
+    uint64_t length;
+    uint64_t offset;        // where the mapping is in the image
+    uint16_t prot;
+};
+
+// a fake process, sys_proc_rw and SYS_PROC_VM_MAP are answered from it
+struct bench_process {
+    uint8_t *image;
+    uint64_t length;
+    struct bench_map *maps;
+    uint32_t numMaps;
+};
+
+// cpus the HW_NCPU sysctl reports, 0 for the ones of the host
+extern uint32_t bench_cpus;
+
+void bench_attach(struct bench_process *process);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _BENCH_PS4_H
+#define _BENCH_PS4_H
+
+// Stands in for the payload sdk header when the scan engine is built on the
+// host, only what the scan sources use is here. The functions are provided
+// by bench/source/stubs.c.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PAGE_SIZE   0x4000
+
+#define PROT_READ   1
+#define PROT_WRITE  2
+#define PROT_EXEC   4
+
+struct timeval {
+    long tv_sec;
+    long tv_usec;
+};
+
+struct in_addr {
+    uint32_t s_addr;
+};
+
+struct sockaddr_in {
+    uint8_t sin_len;
+    uint8_t sin_family;
+    uint16_t sin_port;
+    struct in_addr sin_addr;
+    char sin_zero[8];
+};
+
+typedef void *ScePthread;
+
+int scePthreadCreate(ScePthread *thread, const void *attr, void *(*entry)(void *), void *arg, const char *name);
+int scePthreadJoin(ScePthread thread, void **value);
+void scePthreadYield(void);
+
+long syscall(long number, ...);
+
+#endif
@@ -0,0 +1,440 @@
+#include <time.h>
+
+#include "../include/bench.h"
+
+// Measures the scan engine on the host. Every value and compare type is run
+// against synthetic images with a given hit density, or against recorded
+// memory dumps, once through the bare kernels and once through scan_regions
+// with the worker pool and a sink that only counts.
+
+#define BENCH_BASE      0x200000000ull
+#define BENCH_GAP       0x100000
+#define BENCH_VALUE     7
+
+struct bench_type {
+    const char *name;
+    cmd_proc_scan_valuetype type;
+    uint8_t flags;          // string flags
+};
+
+struct bench_compare {
+    const char *name;
+    cmd_proc_scan_comparetype type;
+    int64_t value;          // compared against, the second value of between
+    int64_t extra;
+};
+
+struct bench_scenario {
+    const char *name;
+    uint64_t every;         // bytes between two planted values, 0 for none
+};
+
+static const struct bench_type types[] = {
+    { "u8", SCAN_VAL_U8, 0 },
+    { "s8", SCAN_VAL_S8, 0 },
+    { "u16", SCAN_VAL_U16, 0 },
+    { "s16", SCAN_VAL_S16, 0 },
+    { "u32", SCAN_VAL_U32, 0 },
+    { "s32", SCAN_VAL_S32, 0 },
+    { "u64", SCAN_VAL_U64, 0 },
+    { "s64", SCAN_VAL_S64, 0 },
+    { "float", SCAN_VAL_FLOAT, 0 },
+    { "double", SCAN_VAL_DOUBLE, 0 },
+    { "bytes", SCAN_VAL_BYTE_ARRAY, 0 },
+    { "string", SCAN_VAL_STRING, 0 },
+    { "utf16/i", SCAN_VAL_STRING, SCAN_FLAG_UTF16 | SCAN_FLAG_NOCASE },
+};
+
+static const struct bench_compare compares[] = {
+    { "exact", SCAN_CMP_EXACT, BENCH_VALUE, 0 },
+    { "bigger", SCAN_CMP_BIGGER_THAN, BENCH_VALUE - 1, 0 },
+    { "between", SCAN_CMP_BETWEEN, BENCH_VALUE - 1, BENCH_VALUE + 1 },
+    { "changed", SCAN_CMP_CHANGED, 0, 0 },
+};
+
+static const struct bench_scenario scenarios[] = {
+    { "none", 0 },
+    { "sparse", 0x10000 },
+    { "dense", 64 },
+};
+
+static const char bench_string[] = "Hello World";
+
+static double bench_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the scan value encoded the way the client would send it
+static uint32_t bench_encode(const struct bench_type *type, int64_t number, uint8_t *out) {
+    switch (type->type) {
+        case SCAN_VAL_U8:
+        case SCAN_VAL_S8:
+            *(int8_t *)out = number;
+            return 1;
+        case SCAN_VAL_U16:
+        case SCAN_VAL_S16:
+            *(int16_t *)out = number;
+            return 2;
+        case SCAN_VAL_U32:
+        case SCAN_VAL_S32:
+            *(int32_t *)out = number;
+            return 4;
+        case SCAN_VAL_U64:
+        case SCAN_VAL_S64:
+            *(int64_t *)out = number;
+            return 8;
+        case SCAN_VAL_FLOAT:
+            *(float *)out = number;
+            return 4;
+        case SCAN_VAL_DOUBLE:
+            *(double *)out = number;
+            return 8;
+        case SCAN_VAL_BYTE_ARRAY:
+            memset(out, (uint8_t)number, 8);
+            return 8;
+        default:
+            memcpy(out, bench_string, sizeof(bench_string) - 1);
+            return sizeof(bench_string) - 1;
+    }
+}
+
+// what the value looks like in memory, strings are planted encoded
+static uint32_t bench_planted(const struct bench_type *type, uint8_t *out) {
+    uint32_t length = bench_encode(type, BENCH_VALUE, out);
+
+    if (type->type == SCAN_VAL_STRING && (type->flags & SCAN_FLAG_UTF16)) {
+        for (uint32_t i = length; i > 0; i--) {
+            out[(i - 1) * 2] = out[i - 1];
+            out[(i - 1) * 2 + 1] = 0;
+        }
+
+        length *= 2;
+    }
+
+    return length;
+}
+
+static void bench_plant(struct bench_process *process, const struct bench_type *type, const struct bench_scenario *scenario) {
+    uint8_t value[64];
+    uint32_t length = bench_planted(type, value);
+    uint32_t align = type->type < SCAN_VAL_BYTE_ARRAY ? length : (type->flags & SCAN_FLAG_UTF16 ? 2 : 1);
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+    memset(process->image, 0, process->length);
+
+    if (!scenario->every) {
+        return;
+    }
+
+    for (uint64_t at = 0; at + scenario->every <= process->length; at += scenario->every) {
+        uint64_t offset;
+
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        offset = (seed % (scenario->every - length)) & ~(uint64_t)(align - 1);
+        memcpy(process->image + at + offset, value, length);
+    }
+}
+
+static void bench_layout(struct bench_process *process, uint64_t length) {
+    static const char *names[] = { "executable", "", "libc.sprx", "" };
+    uint64_t start = BENCH_BASE;
+    uint64_t offset = 0;
+
+    process->numMaps = 4;
+    process->maps = (struct bench_map *)calloc(process->numMaps, sizeof(struct bench_map));
+
+    // halves, the last two share what is left
+    for (uint32_t i = 0; i < process->numMaps; i++) {
+        struct bench_map *map = &process->maps[i];
+
+        map->length = i + 1 < process->numMaps ? (length >> (i + 1)) : length - offset;
+        map->length &= ~(uint64_t)(PAGE_SIZE - 1);
+        map->start = start;
+        map->offset = offset;
+        map->prot = i ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC;
+        snprintf(map->name, sizeof(map->name), "%s", names[i]);
+
+        start += map->length + BENCH_GAP;
+        offset += map->length;
+    }
+
+    process->image = (uint8_t *)malloc(length);
+    process->length = length;
+}
+
+static int bench_load(struct bench_process *process, char **files, uint32_t numFiles) {
+    uint64_t start = BENCH_BASE;
+
+    process->numMaps = numFiles;
+    process->maps = (struct bench_map *)calloc(numFiles, sizeof(struct bench_map));
+    process->length = 0;
+    process->image = NULL;
+
+    for (uint32_t i = 0; i < numFiles; i++) {
+        struct bench_map *map = &process->maps[i];
+        FILE *f = fopen(files[i], "rb");
+        long length;
+
+        if (!f) {
+            fprintf(stderr, "can not open %s\n", files[i]);
+            return 1;
+        }
+
+        fseek(f, 0, SEEK_END);
+        length = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        process->image = (uint8_t *)realloc(process->image, process->length + length);
+        if (!process->image || fread(process->image + process->length, 1, length, f) != (size_t)length) {
+            fclose(f);
+            fprintf(stderr, "can not read %s\n", files[i]);
+            return 1;
+        }
+
+        fclose(f);
+
+        map->start = start;
+        map->length = length;
+        map->offset = process->length;
+        map->prot = PROT_READ | PROT_WRITE;
+        snprintf(map->name, sizeof(map->name), "image%u", i);
+
+        process->length += length;
+        start += ((length + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1)) + BENCH_GAP;
+    }
+
+    return 0;
+}
+
+struct bench_run {
+    scan_kernel_t kernel;
+    const uint8_t *value;
+    const uint8_t *extra;
+    uint32_t valueLength;
+    uint32_t stride;
+    uint32_t extraStride;
+    const uint8_t *previous;    // image the relative compares look at
+};
+
+// the kernels alone on one thread, over every mapping piece by piece
+static uint64_t bench_kernel(struct bench_process *process, struct bench_run *run, uint32_t *hits) {
+    uint64_t count = 0;
+
+    for (uint32_t i = 0; i < process->numMaps; i++) {
+        struct bench_map *map = &process->maps[i];
+
+        for (uint64_t pos = 0; pos < map->length; pos += SCAN_PIECE_SIZE) {
+            uint64_t length = map->length - pos > SCAN_PIECE_SIZE ? SCAN_PIECE_SIZE : map->length - pos;
+            const uint8_t *extra = run->previous ? run->previous + map->offset + pos : run->extra;
+
+            count += run->kernel(process->image + map->offset + pos, length, run->stride, run->value,
+                                 extra, run->extraStride, run->valueLength, hits);
+        }
+    }
+
+    return count;
+}
+
+static int bench_count_hits(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    *(uint64_t *)arg += count;
+    return 0;
+}
+
+// the whole region loop, reads through the stubbed sys_proc_rw included
+static uint64_t bench_regions(struct bench_run *run) {
+    struct proc_vm_map_entry *maps;
+    struct scan_params params;
+    struct scan_sink sink;
+    uint64_t count = 0;
+    uint64_t num;
+
+    if (proc_get_vm_map(1, &maps, &num)) {
+        return 0;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.pid = 1;
+    params.kernel = run->kernel;
+    params.value = run->value;
+    params.extra = run->extra;
+    params.valueLength = run->valueLength;
+    params.stride = run->stride;
+
+    sink.region = NULL;
+    sink.hits = bench_count_hits;
+    sink.progress = NULL;
+    sink.arg = &count;
+
+    scan_regions(&params, maps, num, &sink);
+
+    free(maps);
+
+    return count;
+}
+
+static double bench_rate(uint64_t bytes, double seconds) {
+    return seconds > 0 ? bytes / seconds / 1e9 : 0;
+}
+
+static void bench_case(struct bench_process *process, const struct bench_type *type, const struct bench_compare *compare,
+                       const char *scenario, uint32_t repeats, uint32_t *hits, uint8_t *previous) {
+    struct text_pattern text;
+    struct bench_run run;
+    uint8_t value[64];
+    uint8_t extra[64];
+    double kernelTime = 1e30;
+    double regionsTime = 1e30;
+    uint64_t kernelHits = 0;
+    uint64_t regionsHits = 0;
+    int relative = scan_is_relative(compare->type);
+
+    memset(&run, 0, sizeof(run));
+    run.valueLength = bench_encode(type, compare->value, value);
+    bench_encode(type, compare->extra, extra);
+    run.value = value;
+    run.extra = compare->type == SCAN_CMP_BETWEEN ? extra : NULL;
+    run.stride = run.valueLength;
+    run.kernel = scan_get_kernel(type->type, compare->type);
+
+    if (type->type == SCAN_VAL_STRING) {
+        if (compare->type != SCAN_CMP_EXACT || text_compile(&text, value, run.valueLength, type->flags)) {
+            return;
+        }
+
+        run.kernel = text_kernel;
+        run.value = (const uint8_t *)&text;
+        run.valueLength = text.length;
+        run.stride = text.unit;
+    } else if (type->type == SCAN_VAL_BYTE_ARRAY) {
+        run.stride = 1;
+    }
+
+    if (!run.kernel) {
+        return;
+    }
+
+    if (relative) {
+        run.previous = previous;
+        run.extraStride = run.valueLength;
+    }
+
+    for (uint32_t i = 0; i < repeats; i++) {
+        double start = bench_now();
+        kernelHits = bench_kernel(process, &run, hits);
+        double elapsed = bench_now() - start;
+        if (elapsed < kernelTime) {
+            kernelTime = elapsed;
+        }
+
+        // the previous values only exist in a session, not in a plain scan
+        if (relative) {
+            continue;
+        }
+
+        start = bench_now();
+        regionsHits = bench_regions(&run);
+        elapsed = bench_now() - start;
+        if (elapsed < regionsTime) {
+            regionsTime = elapsed;
+        }
+    }
+
+    if (relative) {
+        printf("%-8s %-8s %-10s %12llu %10.2f %10s\n", type->name, compare->name, scenario,
+               (unsigned long long)kernelHits, bench_rate(process->length, kernelTime), "-");
+    } else {
+        printf("%-8s %-8s %-10s %12llu %10.2f %10.2f%s\n", type->name, compare->name, scenario,
+               (unsigned long long)kernelHits, bench_rate(process->length, kernelTime), bench_rate(process->length, regionsTime),
+               kernelHits == regionsHits ? "" : "  (hit count differs)");
+    }
+}
+
+static void bench_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-s megabytes] [-n repeats] [-c cpus] [-t type] [image ...]\n", name);
+    fprintf(stderr, "  without images a synthetic process is scanned at every hit density\n");
+}
+
+int main(int argc, char **argv) {
+    struct bench_process process;
+    const char *only = NULL;
+    uint64_t megabytes = 256;
+    uint32_t repeats = 3;
+    uint32_t numFiles = 0;
+    char **files;
+    uint32_t *hits;
+    uint8_t *previous;
+
+    files = (char **)calloc(argc, sizeof(char *));
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            megabytes = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            repeats = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            bench_cpus = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            only = argv[++i];
+        } else if (argv[i][0] == '-') {
+            bench_usage(argv[0]);
+            return 1;
+        } else {
+            files[numFiles++] = argv[i];
+        }
+    }
+
+    if (!megabytes || !repeats) {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    memset(&process, 0, sizeof(process));
+    if (numFiles) {
+        if (bench_load(&process, files, numFiles)) {
+            return 1;
+        }
+    } else {
+        bench_layout(&process, megabytes << 20);
+    }
+
+    hits = (uint32_t *)malloc(SCAN_MAX_HITS(SCAN_PIECE_SIZE, 1) * sizeof(uint32_t));
+
+    // the relative compares see every value as changed from zero
+    previous = (uint8_t *)calloc(1, process.length);
+
+    if (!process.image || !hits || !previous) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    bench_attach(&process);
+
+    printf("%llu MB in %u mappings, best of %u\n", (unsigned long long)(process.length >> 20), process.numMaps, repeats);
+    printf("%-8s %-8s %-10s %12s %10s %10s\n", "type", "compare", "scenario", "hits", "kernel", "regions");
+
+    for (uint32_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        if (only && strcmp(only, types[t].name)) {
+            continue;
+        }
+
+        uint32_t numScenarios = numFiles ? 1 : sizeof(scenarios) / sizeof(scenarios[0]);
+        for (uint32_t s = 0; s < numScenarios; s++) {
+            if (!numFiles) {
+                bench_plant(&process, &types[t], &scenarios[s]);
+            }
+
+            for (uint32_t c = 0; c < sizeof(compares) / sizeof(compares[0]); c++) {
+                bench_case(&process, &types[t], &compares[c], numFiles ? "image" : scenarios[s].name, repeats, hits, previous);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "../include/bench.h"
+
+// the process being scanned, its mappings laid out back to back in image
+static struct bench_process *current;
+
+uint32_t bench_cpus;
+
+void bench_attach(struct bench_process *process) {
+    current = process;
+}
+
+static struct bench_map *bench_find_map(uint64_t address) {
+    for (uint32_t i = 0; i < current->numMaps; i++) {
+        struct bench_map *map = &current->maps[i];
+        if (address >= map->start && address < map->start + map->length) {
+            return map;
+        }
+    }
+
+    return NULL;
+}
+
+int sys_proc_rw(uint64_t pid, uint64_t address, void *data, uint64_t length, uint64_t write) {
+    struct bench_map *map = bench_find_map(address);
+
+    // reads past the end of a mapping fail like they do on the console
+    if (!map || address + length > map->start + map->length) {
+        memset(data, 0, length);
+        return 1;
+    }
+
+    if (write) {
+        memcpy(current->image + map->offset + (address - map->start), data, length);
+    } else {
+        memcpy(data, current->image + map->offset + (address - map->start), length);
+    }
+
+    return 0;
+}
+
+int sys_proc_cmd(uint64_t pid, uint64_t cmd, void *data) {
+    struct sys_proc_vm_map_args *args = (struct sys_proc_vm_map_args *)data;
+
+    // SYS_PROC_SCAN is left to the userland kernels, that is what gets measured
+    if (cmd != SYS_PROC_VM_MAP) {
+        return 1;
+    }
+
+    if (!args->maps) {
+        args->num = current->numMaps;
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < current->numMaps && i < args->num; i++) {
+        memset(&args->maps[i], 0, sizeof(struct proc_vm_map_entry));
+        snprintf(args->maps[i].name, sizeof(args->maps[i].name), "%s", current->maps[i].name);
+        args->maps[i].start = current->maps[i].start;
+        args->maps[i].end = current->maps[i].start + current->maps[i].length;
+        args->maps[i].prot = current->maps[i].prot;
+    }
+
+    return 0;
+}
+
+// same as the one in proc.c, which can not be built on the host
+int proc_get_vm_map(uint32_t pid, struct proc_vm_map_entry **maps, uint64_t *num) {
+    struct sys_proc_vm_map_args args;
+
+    memset(&args, 0, sizeof(args));
+    if (sys_proc_cmd(pid, SYS_PROC_VM_MAP, &args)) {
+        return 1;
+    }
+
+    args.maps = (struct proc_vm_map_entry *)malloc(args.num * sizeof(struct proc_vm_map_entry));
+    if (!args.maps) {
+        return 1;
+    }
+
+    if (sys_proc_cmd(pid, SYS_PROC_VM_MAP, &args)) {
+        free(args.maps);
+        return 1;
+    }
+
+    *maps = args.maps;
+    *num = args.num;
+
+    return 0;
+}
+
+size_t proc_scan_getSizeOfValueType(cmd_proc_scan_valuetype valType) {
+    switch (valType) {
+        case SCAN_VAL_U8:
+        case SCAN_VAL_S8:
+            return 1;
+        case SCAN_VAL_U16:
+        case SCAN_VAL_S16:
+            return 2;
+        case SCAN_VAL_U32:
+        case SCAN_VAL_S32:
+        case SCAN_VAL_FLOAT:
+            return 4;
+        case SCAN_VAL_U64:
+        case SCAN_VAL_S64:
+        case SCAN_VAL_DOUBLE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+void prefault(void *address, size_t size) {
+    if (!size) {
+        return;
+    }
+
+    for (size_t i = 0; i < size; i += PAGE_SIZE) {
+        volatile uint8_t *c = (volatile uint8_t *)address + i;
+        *c = *c;
+    }
+
+    volatile uint8_t *c = (volatile uint8_t *)address + size - 1;
+    *c = *c;
+}
+
+void *pfmalloc(size_t size) {
+    void *p = malloc(size);
+    if (p) {
+        memset(p, 0, size);
+    }
+
+    return p;
+}
+
+int uprintf(const char *fmt, ...) {
+    return 0;
+}
+
+int scePthreadCreate(ScePthread *thread, const void *attr, void *(*entry)(void *), void *arg, const char *name) {
+    return pthread_create((pthread_t *)thread, NULL, entry, arg);
+}
+
+int scePthreadJoin(ScePthread thread, void **value) {
+    return pthread_join((pthread_t)thread, value);
+}
+
+void scePthreadYield(void) {
+    sched_yield();
+}
+
+// only the HW_NCPU sysctl is used by the scan engine
+long syscall(long number, ...) {
+    va_list args;
+    int *mib;
+    int *out;
+    long ncpu;
+
+    if (number != 202) {
+        return -1;
+    }
+
+    va_start(args, number);
+    mib = va_arg(args, int *);
+    va_arg(args, int);
+    out = va_arg(args, int *);
+    va_end(args);
+
+    if (mib[0] != 6 || mib[1] != 3) {
+        return -1;
+    }
+
+    ncpu = bench_cpus ? bench_cpus : sysconf(_SC_NPROCESSORS_ONLN);
+    *out = (int)(ncpu > 0 ? ncpu : 1);
+
+    return 0;
+}
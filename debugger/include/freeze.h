@@ -0,0 +1,35 @@
+#ifndef _FREEZE_H
+#define _FREEZE_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "kdbg.h"
+
+#define FREEZE_MAX_ENTRIES  0x400
+#define FREEZE_MAX_LENGTH   0x100
+#define FREEZE_MIN_PERIOD   1       // milliseconds
+#define FREEZE_IDLE         100000  // longest sleep of the freeze thread in microseconds
+
+struct freeze_entry {
+    uint32_t id;            // 0 for a free slot
+    uint32_t pid;
+    uint64_t address;
+    uint16_t length;
+    uint32_t period;        // milliseconds
+    uint64_t due;           // process time of the next write
+    uint8_t bytes[FREEZE_MAX_LENGTH];
+};
+
+// The freezes are shared by every client and outlive the one that added
+// them, a single thread rewrites them with one SYS_PROC_WRITE_V per process.
+// Entries of a process that went away are dropped.
+
+// returns the id of the new entry, 0 when the table is full or the thread
+// could not be started
+uint32_t freeze_add(uint32_t pid, uint64_t address, const uint8_t *bytes, uint16_t length, uint32_t period);
+// id 0 removes every entry, returns the number removed
+uint32_t freeze_remove(uint32_t id);
+// copies up to max entries, returns how many there are
+uint32_t freeze_list(struct freeze_entry *entries, uint32_t max);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _GROUP_H
+#define _GROUP_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "scan.h"
+
+#define GROUP_MAX_MEMBERS   16
+#define GROUP_MAX_DISTANCE  0x1000
+
+struct group_member {
+    uint8_t valueType;
+    uint32_t length;
+    uint32_t align;         // the value size, 1 for byte arrays and strings
+    uint32_t distance;
+    const uint8_t *value;
+};
+
+// Values that have to be found close to each other. The first member is the
+// anchor that is scanned for, every other one has to be somewhere within its
+// distance of the anchor, aligned to its size and not overlapping the anchor.
+struct scan_group {
+    struct group_member members[GROUP_MAX_MEMBERS];
+    uint32_t count;
+    uint32_t before;        // bytes in front of the anchor a member may use
+    uint32_t after;         // bytes from the anchor to the end of the furthest member
+};
+
+// parses the CMD_PROC_SCAN data of a SCAN_VAL_GROUP scan, the members point
+// into data
+int group_init(struct scan_group *group, const uint8_t *data, uint32_t length);
+
+// scans for the anchor and only hands the anchors where the whole group
+// matched to the sink, stride 0 aligns the anchor to its size
+int group_scan(uint32_t pid, struct scan_group *group, uint32_t stride, uint32_t chunkSize,
+               struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink);
+
+#endif
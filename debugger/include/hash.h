@@ -0,0 +1,9 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <ps4.h>
+
+// XXH64, so clients can use any xxHash implementation to compare against
+uint64_t hash_xxh64(const uint8_t *data, uint64_t length, uint64_t seed);
+
+#endif
@@ -23,6 +23,8 @@
 #define SYS_PROC_ELF              7
 #define SYS_PROC_INFO             8
 #define SYS_PROC_THRINFO          9
+#define SYS_PROC_SCAN             10
+#define SYS_PROC_WRITE_V          11
 
 // custom syscall 107
 struct proc_list_entry {
@@ -86,6 +88,36 @@ struct sys_proc_thrinfo_args {
     char name[32];
 } __attribute__((packed));
 
+// value and compare types are the scan protocol ones, only the integer values
+// compared against a fixed value
+struct sys_proc_scan_args {
+    uint64_t address;
+    uint64_t length;
+    uint64_t limit;
+    uint32_t valueType;
+    uint32_t compareType;
+    uint8_t value[8];
+    uint8_t extra[8];
+    uint32_t stride;
+    uint8_t *data;
+    uint32_t *hits;
+    uint32_t maxHits;
+    uint32_t count;
+} __attribute__((packed));
+
+// writes every entry in one call, failed counts the ones that could not be
+struct sys_proc_write_v_entry {
+    uint64_t address;
+    uint8_t *data;
+    uint32_t length;
+} __attribute__((packed));
+
+struct sys_proc_write_v_args {
+    struct sys_proc_write_v_entry *entries;
+    uint32_t count;
+    uint32_t failed;
+} __attribute__((packed));
+
 void prefault(void *address, size_t size);
 void *pfmalloc(size_t size);
 void hexdump(void *data, size_t size);
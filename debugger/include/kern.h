@@ -4,6 +4,7 @@
 #include <ps4.h>
 #include "protocol.h"
 #include "net.h"
+#include "transfer.h"
 
 int kern_handle(int fd, struct cmd_packet *packet);
 int kern_base_handle(int fd, struct cmd_packet *packet);
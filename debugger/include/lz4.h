@@ -0,0 +1,18 @@
+#ifndef _LZ4_H
+#define _LZ4_H
+
+#include <ps4.h>
+
+// LZ4 block format, without the frame around it. The compressor is the plain
+// greedy one, fast enough to stay ahead of the network.
+
+#define LZ4_HASH_LOG        12
+#define LZ4_TABLE_SIZE      ((1 << LZ4_HASH_LOG) * sizeof(uint32_t))
+
+// compresses length bytes into at most capacity bytes, table is scratch of
+// LZ4_TABLE_SIZE bytes, returns 0 when the result does not fit
+uint32_t lz4_compress(const uint8_t *src, uint32_t length, uint8_t *dst, uint32_t capacity, uint32_t *table);
+// returns 0 when the block decodes to exactly rawLength bytes
+int lz4_decompress(const uint8_t *src, uint32_t length, uint8_t *dst, uint32_t rawLength);
+
+#endif
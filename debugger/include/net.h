@@ -6,6 +6,9 @@
 
 #define NET_MAX_LENGTH  8192
 
+// connections the server takes at once, tables kept per client are this big
+#define SERVER_MAXCLIENTS       8
+
 #define SO_USELOOPBACK 0x0040     // bypass hardware when possible 
 #define SO_LINGER      0x0080     // linger on close if data present 
 #define SO_NOSIGPIPE   0x0800     // no SIGPIPE from EPIPE 
@@ -41,6 +44,7 @@ int FD_ISSET(int d, fd_set *set);
 
 int net_select(int fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
 int net_send_data(int fd, void *data, int length);
+int net_send_block(int fd, void *data, int length);
 int net_recv_data(int fd, void *data, int length, int force);
 int net_send_status(int fd, uint32_t status);
 
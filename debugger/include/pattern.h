@@ -0,0 +1,65 @@
+#ifndef _PATTERN_H
+#define _PATTERN_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "scan.h"
+
+#define PATTERN_MAX_LENGTH  0x1000
+#define PATTERN_MAX_COUNT   1024
+
+// A byte pattern with wildcards, compiled for a Horspool search. Leading and
+// trailing wildcards are not searched for, they only have to fit.
+struct pattern {
+    const uint8_t *bytes;
+    const uint8_t *mask;    // 0 marks a wildcard byte
+    uint32_t length;
+    uint32_t first;         // first byte that is not a wildcard
+    uint32_t last;          // last byte that is not a wildcard
+    uint32_t shift[256];
+};
+
+// Many patterns searched in one pass. Every pattern is indexed by the two
+// bytes at its first concrete byte (or just the one when the next byte is a
+// wildcard), a bit filter rejects most positions before any bucket is looked at.
+struct pattern_key {
+    uint16_t key;
+    uint16_t index;
+};
+
+struct pattern_set {
+    struct pattern *patterns;
+    uint32_t count;
+    uint32_t span;          // longest first..last stretch, the read overlap
+    struct pattern_key *pairs;
+    uint32_t numPairs;
+    struct pattern_key *singles;
+    uint32_t numSingles;
+    uint64_t pairFilter[0x10000 / 64];
+    uint64_t singleFilter[0x100 / 64];
+};
+
+int pattern_compile(struct pattern *pattern, const uint8_t *bytes, const uint8_t *mask, uint32_t length);
+
+// scan_kernel_t over a compiled pattern, value points to the struct pattern
+uint32_t pattern_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                        const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                        uint32_t valueLength, uint32_t *hits);
+
+int pattern_set_init(struct pattern_set *set, struct pattern *patterns, uint32_t count);
+void pattern_set_free(struct pattern_set *set);
+
+// writes the index of every pattern whose first concrete byte is at pos into
+// matches (if not NULL), memory holds length bytes
+uint32_t pattern_set_match(const struct pattern_set *set, const uint8_t *memory, uint32_t length, uint32_t pos, uint32_t *matches);
+
+// scan_kernel_t over a struct pattern_set, hits are the offsets where at least
+// one pattern matched its first concrete byte
+uint32_t pattern_set_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                            const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                            uint32_t valueLength, uint32_t *hits);
+
+int pattern_scan(uint32_t pid, struct pattern *pattern, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink);
+int pattern_set_scan(uint32_t pid, struct pattern_set *set, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink);
+
+#endif
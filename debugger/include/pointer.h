@@ -0,0 +1,48 @@
+#ifndef _POINTER_H
+#define _POINTER_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "net.h"
+#include "scan.h"
+
+#define POINTER_MAX         SERVER_MAXCLIENTS
+#define POINTER_MAX_VISITS  0x1000000   // pointers followed per search before giving up
+
+struct pointer_entry {
+    uint64_t value;
+    uint64_t address;
+};
+
+struct pointer_region {
+    uint64_t start;
+    uint64_t end;
+    uint64_t base;          // start of the first mapping with the same name
+    int module;             // segment of an executable image, chains may start here
+};
+
+// Every 8 byte aligned value of a process that points into one of its
+// mappings, sorted by value. Built once per client and reused by the searches.
+struct pointer_map {
+    int fd;
+    uint32_t pid;
+    struct pointer_entry *entries;
+    uint64_t count;
+    uint64_t capacity;
+    struct pointer_region *regions;
+    uint64_t numRegions;
+};
+
+// receives each chain found, a non zero return stops the search
+typedef int (*pointer_chain_t)(void *arg, struct cmd_proc_pointer_chain *chain);
+
+struct pointer_map *pointer_find(int fd);
+struct pointer_map *pointer_build(int fd, uint32_t pid);
+void pointer_free(int fd);
+
+// walks back from target through at most maxDepth pointers, each pointing at
+// most maxOffset bytes below the next address, returns the chains found
+uint64_t pointer_search(struct pointer_map *map, uint64_t target, uint32_t maxDepth, uint32_t maxOffset,
+                        uint64_t maxResults, pointer_chain_t chain, void *arg);
+
+#endif
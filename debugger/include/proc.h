@@ -5,6 +5,16 @@
 #include <stdbool.h>
 #include "protocol.h"
 #include "net.h"
+#include "scan.h"
+#include "session.h"
+#include "pattern.h"
+#include "pointer.h"
+#include "group.h"
+#include "text.h"
+#include "transfer.h"
+#include "watch.h"
+#include "freeze.h"
+#include "hash.h"
 
 struct proc_vm_map_entry {
     char name[32];
@@ -14,14 +24,35 @@ struct proc_vm_map_entry {
     uint16_t prot;
 } __attribute__((packed));
 
+int proc_get_vm_map(uint32_t pid, struct proc_vm_map_entry **maps, uint64_t *num);
+size_t proc_scan_getSizeOfValueType(cmd_proc_scan_valuetype valType);
+
 int proc_list_handle(int fd, struct cmd_packet *packet);
 int proc_read_handle(int fd, struct cmd_packet *packet);
+int proc_read_v_handle(int fd, struct cmd_packet *packet);
+int proc_read_delta_handle(int fd, struct cmd_packet *packet);
 int proc_write_handle(int fd, struct cmd_packet *packet);
+int proc_write_v_handle(int fd, struct cmd_packet *packet);
+int proc_transfer_handle(int fd, struct cmd_packet *packet);
+int proc_watch_handle(int fd, struct cmd_packet *packet);
+int proc_freeze_add_handle(int fd, struct cmd_packet *packet);
+int proc_freeze_remove_handle(int fd, struct cmd_packet *packet);
+int proc_freeze_list_handle(int fd, struct cmd_packet *packet);
 int proc_maps_handle(int fd, struct cmd_packet *packet);
 int proc_install_handle(int fd, struct cmd_packet *packet);
 int proc_call_handle(int fd, struct cmd_packet *packet);
 int proc_protect_handle(int fd, struct cmd_packet *packet);
 int proc_scan_handle(int fd, struct cmd_packet *packet);
+int proc_scan_open_handle(int fd, struct cmd_packet *packet);
+int proc_scan_next_handle(int fd, struct cmd_packet *packet);
+int proc_scan_results_handle(int fd, struct cmd_packet *packet);
+int proc_scan_close_handle(int fd, struct cmd_packet *packet);
+int proc_scan_set_handle(int fd, struct cmd_packet *packet);
+int proc_scan_pattern_handle(int fd, struct cmd_packet *packet);
+int proc_scan_patterns_handle(int fd, struct cmd_packet *packet);
+int proc_pointer_map_handle(int fd, struct cmd_packet *packet);
+int proc_pointer_scan_handle(int fd, struct cmd_packet *packet);
+int proc_pointer_close_handle(int fd, struct cmd_packet *packet);
 int proc_info_handle(int fd, struct cmd_packet *packet);
 int proc_alloc_handle(int fd, struct cmd_packet *packet);
 int proc_free_handle(int fd, struct cmd_packet *packet);
@@ -5,7 +5,7 @@
 #include "errno.h"
 #include "kdbg.h"
 
-#define PACKET_VERSION          "1.2"
+#define PACKET_VERSION          "1.3"
 #define PACKET_MAGIC            0xFFAABBCC
 
 #define CMD_VERSION             0xBD000001
@@ -22,6 +22,25 @@
 #define CMD_PROC_INFO           0xBDAA000A
 #define CMD_PROC_ALLOC          0xBDAA000B
 #define CMD_PROC_FREE           0xBDAA000C
+#define CMD_PROC_SCAN_OPEN      0xBDAA000D
+#define CMD_PROC_SCAN_NEXT      0xBDAA000E
+#define CMD_PROC_SCAN_RESULTS   0xBDAA000F
+#define CMD_PROC_SCAN_CLOSE     0xBDAA0010
+#define CMD_PROC_SCAN_SET       0xBDAA0011
+#define CMD_PROC_SCAN_PATTERN   0xBDAA0012
+#define CMD_PROC_SCAN_PATTERNS  0xBDAA0013
+#define CMD_PROC_POINTER_MAP    0xBDAA0014
+#define CMD_PROC_POINTER_SCAN   0xBDAA0015
+#define CMD_PROC_POINTER_CLOSE  0xBDAA0016
+#define CMD_PROC_SCAN_CANCEL    0xBDAA0017
+#define CMD_PROC_READ_V         0xBDAA0018
+#define CMD_PROC_WRITE_V        0xBDAA0019
+#define CMD_PROC_TRANSFER       0xBDAA001A
+#define CMD_PROC_WATCH          0xBDAA001B
+#define CMD_PROC_FREEZE_ADD     0xBDAA001C
+#define CMD_PROC_FREEZE_REMOVE  0xBDAA001D
+#define CMD_PROC_FREEZE_LIST    0xBDAA001E
+#define CMD_PROC_READ_DELTA     0xBDAA001F
 
 #define CMD_DEBUG_ATTACH        0xBDBB0001
 #define CMD_DEBUG_DETACH        0xBDBB0002
@@ -67,19 +86,51 @@
 
 #define CMD_PACKET_SIZE 12
 #define CMD_PROC_READ_PACKET_SIZE 16
+#define CMD_PROC_READ_V_PACKET_SIZE 8
+#define CMD_PROC_READ_V_ENTRY_SIZE 12
 #define CMD_PROC_WRITE_PACKET_SIZE 16
+#define CMD_PROC_WRITE_V_PACKET_SIZE 13
+#define CMD_PROC_WRITE_V_ENTRY_SIZE 12
+#define CMD_PROC_TRANSFER_PACKET_SIZE 8
+#define CMD_PROC_TRANSFER_RESPONSE_SIZE 8
+#define CMD_PROC_TRANSFER_BLOCK_SIZE 8
+#define CMD_PROC_WATCH_PACKET_SIZE 4
+#define CMD_PROC_WATCH_ENTRY_SIZE 18
+#define CMD_PROC_WATCH_FRAME_SIZE 16
+#define CMD_PROC_WATCH_VALUE_SIZE 6
+#define CMD_PROC_FREEZE_ADD_PACKET_SIZE 18
+#define CMD_PROC_FREEZE_ADD_RESPONSE_SIZE 4
+#define CMD_PROC_FREEZE_REMOVE_PACKET_SIZE 4
+#define CMD_PROC_FREEZE_ENTRY_SIZE 22
+#define CMD_PROC_READ_DELTA_PACKET_SIZE 20
+#define CMD_PROC_READ_DELTA_BLOCK_SIZE 8
 #define CMD_PROC_MAPS_PACKET_SIZE 4
 #define CMD_PROC_INSTALL_PACKET_SIZE 4
 #define CMD_PROC_INSTALL_RESPONSE_SIZE 8
 #define CMD_PROC_CALL_PACKET_SIZE 68
 #define CMD_PROC_CALL_RESPONSE_SIZE 12
 #define CMD_PROC_ELF_PACKET_SIZE 8
-#define CMD_PROC_SCAN_PACKET_SIZE 10
+#define CMD_PROC_SCAN_PACKET_SIZE 15
+#define CMD_PROC_SCAN_FRAME_SIZE 5
+#define CMD_PROC_SCAN_SUMMARY_SIZE 24
+#define CMD_PROC_SCAN_FILTER_SIZE 57
+#define CMD_PROC_SCAN_GROUP_ENTRY_SIZE 5
 #define CMD_PROC_INFO_PACKET_SIZE 4
 #define CMD_PROC_INFO_RESPONSE_SIZE 188
 #define CMD_PROC_ALLOC_PACKET_SIZE 8
 #define CMD_PROC_ALLOC_RESPONSE_SIZE 8
 #define CMD_PROC_FREE_PACKET_SIZE 16
+#define CMD_PROC_SCAN_OPEN_PACKET_SIZE 15
+#define CMD_PROC_SCAN_NEXT_PACKET_SIZE 5
+#define CMD_PROC_SCAN_COUNT_RESPONSE_SIZE 8
+#define CMD_PROC_SCAN_RESULTS_PACKET_SIZE 12
+#define CMD_PROC_SCAN_SET_REGION_SIZE 29
+#define CMD_PROC_SCAN_PATTERN_PACKET_SIZE 9
+#define CMD_PROC_SCAN_PATTERNS_PACKET_SIZE 12
+#define CMD_PROC_SCAN_PATTERNS_RESULT_SIZE 8
+#define CMD_PROC_POINTER_MAP_PACKET_SIZE 4
+#define CMD_PROC_POINTER_SCAN_PACKET_SIZE 20
+#define CMD_PROC_POINTER_CHAIN_SIZE 52
 #define CMD_DEBUG_ATTACH_PACKET_SIZE 4
 #define CMD_DEBUG_BREAKPT_PACKET_SIZE 16
 #define CMD_DEBUG_WATCHPT_PACKET_SIZE 24
@@ -116,12 +167,146 @@ struct cmd_proc_read_packet {
     uint32_t length;
 } __attribute__((packed));
 
+// followed by count entries. Once they are in a second status is sent, then
+// one uint32_t status per entry in the order they were sent and the data of
+// every entry back to back, a failed entry is sent as zeros
+struct cmd_proc_read_v_packet {
+    uint32_t pid;
+    uint32_t count;
+} __attribute__((packed));
+
+struct cmd_proc_read_v_entry {
+    uint64_t address;
+    uint32_t length;
+} __attribute__((packed));
+
+#define READ_DELTA_END 0xFFFFFFFF
+
+// followed by one uint64_t XXH64 (seed 0) per block of the client's copy,
+// blockSize 0 is the page size. Once they are in a second status is sent,
+// then a block header for every block whose hash differs followed by its
+// bytes, an unreadable block has length 0. A header with index
+// READ_DELTA_END ends the reply
+struct cmd_proc_read_delta_packet {
+    uint32_t pid;
+    uint64_t address;
+    uint32_t length;
+    uint32_t blockSize;
+} __attribute__((packed));
+
+struct cmd_proc_read_delta_block {
+    uint32_t index;
+    uint32_t length;
+} __attribute__((packed));
+
 struct cmd_proc_write_packet {
     uint32_t pid;
     uint64_t address;
     uint32_t length;
 } __attribute__((packed));
 
+#define WRITE_V_FLAG_ATOMIC     1 // all patches or none, the ones applied are rolled back
+
+// followed by length bytes holding count entries, each one followed by the
+// bytes to write. Once they are in a second status is sent, CMD_SUCCESS when
+// every patch was applied, then one uint32_t status per entry in the order
+// they were sent telling if its patch is in memory
+struct cmd_proc_write_v_packet {
+    uint32_t pid;
+    uint32_t count;
+    uint32_t length;
+    uint8_t flags;
+} __attribute__((packed));
+
+struct cmd_proc_write_v_entry {
+    uint64_t address;
+    uint32_t length;
+} __attribute__((packed));
+
+#define TRANSFER_FLAG_LZ4       1 // bulk data goes in blocks, LZ4 compressed where that helps
+
+// sets the chunk size reads are sent in and how bulk data is encoded, the
+// reply holds the size the server settled on (a multiple of the page size)
+// and the flags it accepted
+struct cmd_proc_transfer_packet {
+    uint32_t chunkSize;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct cmd_proc_transfer_response {
+    uint32_t chunkSize;
+    uint32_t flags;
+} __attribute__((packed));
+
+// With TRANSFER_FLAG_LZ4 the data of CMD_PROC_READ, CMD_PROC_WRITE,
+// CMD_KERN_READ and CMD_KERN_WRITE is sent as blocks of at most chunkSize
+// raw bytes, each one a header followed by length bytes. A block of length
+// rawLength is raw, a shorter one is an LZ4 block. Writes have to be split
+// into blocks of exactly chunkSize bytes, only the last one may be shorter.
+struct cmd_proc_transfer_block {
+    uint32_t rawLength;
+    uint32_t length;
+} __attribute__((packed));
+
+#define WATCH_PORT 756
+
+// followed by count entries, they replace the watches the client had and
+// none stops them. The server connects back to the client on WATCH_PORT (it
+// has to listen before sending the first watches) and samples every entry
+// each interval milliseconds, a round that saw values change pushes a frame
+// followed by count values, each one followed by its bytes. A value of
+// length 0 could not be read.
+struct cmd_proc_watch_packet {
+    uint32_t count;
+} __attribute__((packed));
+
+struct cmd_proc_watch_entry {
+    uint32_t pid;
+    uint64_t address;
+    uint16_t length;
+    uint32_t interval;
+} __attribute__((packed));
+
+struct cmd_proc_watch_frame {
+    uint64_t time;          // process time of the round in microseconds
+    uint32_t count;
+    uint32_t length;        // bytes of values following
+} __attribute__((packed));
+
+struct cmd_proc_watch_value {
+    uint32_t index;         // of the entry in the order they were sent
+    uint16_t length;
+} __attribute__((packed));
+
+// followed by length bytes that get written to address every period
+// milliseconds until the entry is removed or the process exits. The freezes
+// are not tied to the client, they keep going after it disconnects
+struct cmd_proc_freeze_add_packet {
+    uint32_t pid;
+    uint64_t address;
+    uint16_t length;
+    uint32_t period;
+} __attribute__((packed));
+
+struct cmd_proc_freeze_add_response {
+    uint32_t id;
+} __attribute__((packed));
+
+// id 0 removes every freeze
+struct cmd_proc_freeze_remove_packet {
+    uint32_t id;
+} __attribute__((packed));
+
+// CMD_PROC_FREEZE_LIST replies with an uint32_t count and then one of these
+// per freeze, each one followed by its bytes
+struct cmd_proc_freeze_entry {
+    uint32_t id;
+    uint32_t pid;
+    uint64_t address;
+    uint16_t length;
+    uint32_t period;
+} __attribute__((packed));
+
 struct cmd_proc_maps_packet {
     uint32_t pid;
 } __attribute__((packed));
@@ -174,7 +359,8 @@ typedef enum cmd_proc_scan_valuetype {
     SCAN_VAL_FLOAT,
     SCAN_VAL_DOUBLE,
     SCAN_VAL_BYTE_ARRAY,
-    SCAN_VAL_STRING
+    SCAN_VAL_STRING,
+    SCAN_VAL_GROUP
 }cmd_proc_scan_valuetype;
 
 typedef enum cmd_proc_scan_comparetype {
@@ -192,11 +378,71 @@ typedef enum cmd_proc_scan_comparetype {
     SCAN_CMP_UNKNOWN_INITIAL
 }cmd_proc_scan_comparetype;
 
+#define SCAN_FLAG_VALUES        1 // hit entries carry the matched value after the address
+#define SCAN_FLAG_FILTER        2 // a struct cmd_proc_scan_filter is sent before the value
+#define SCAN_FLAG_UTF16         4 // SCAN_VAL_STRING: search the UTF-8 value as UTF-16LE
+#define SCAN_FLAG_NOCASE        8 // SCAN_VAL_STRING: ASCII letters match either case
+#define SCAN_FLAG_SYSTEM        16 // integer compares against the value run in the kdebugger, only the hits are copied out
+
 struct cmd_proc_scan_packet {
     uint32_t pid;
     uint8_t valueType;
     uint8_t compareType;
     uint32_t lenData;
+    uint8_t flags;
+    uint32_t chunkSize;     // bytes read at a time, 0 for the default
+} __attribute__((packed));
+
+// The data of a SCAN_VAL_GROUP scan is a list of these, each one followed by
+// length bytes of its value. The first is the anchor that gets reported, the
+// others have to be within distance bytes of it (either way). Only exact
+// compares, compareType is not used.
+struct cmd_proc_scan_group_entry {
+    uint8_t valueType;
+    uint16_t length;
+    uint16_t distance;
+} __attribute__((packed));
+
+// Limits a scan to some of the mappings. An empty name with SCAN_NAME_INCLUDE
+// only keeps the unnamed mappings, with SCAN_NAME_EXCLUDE only the named ones
+#define SCAN_NAME_ANY           0
+#define SCAN_NAME_INCLUDE       1 // the mapping name has to contain name
+#define SCAN_NAME_EXCLUDE       2 // the mapping name must not contain name
+
+struct cmd_proc_scan_filter {
+    uint64_t start;         // only values starting in [start, end)
+    uint64_t end;           // 0 for no upper bound
+    uint16_t protSet;       // prot bits a mapping has to have
+    uint16_t protClear;     // prot bits a mapping must not have
+    uint32_t stride;        // distance between compared values, 0 for the value size
+    uint8_t nameMode;
+    char name[32];
+} __attribute__((packed));
+
+// CMD_PROC_SCAN streams its results as frames, a SCAN_FRAME_HITS frame is
+// followed by count entries of an uint64_t address (and the value with
+// SCAN_FLAG_VALUES), the last frame is SCAN_FRAME_END followed by the summary.
+// SCAN_FRAME_PROGRESS frames carry the summary so far every now and then.
+// While the frames come in the client may send a CMD_PROC_SCAN_CANCEL packet
+// (and nothing else), the scan then stops after the chunk it is on and ends
+// with SCAN_FRAME_CANCEL instead. A cancel that arrives after the end frame is
+// dropped without a reply. A scan that failed part way (out of memory) ends
+// with SCAN_FRAME_ERROR, the hits sent until then are not the whole result.
+#define SCAN_FRAME_HITS         0
+#define SCAN_FRAME_END          1
+#define SCAN_FRAME_PROGRESS     2
+#define SCAN_FRAME_CANCEL       3
+#define SCAN_FRAME_ERROR        4
+
+struct cmd_proc_scan_frame {
+    uint8_t type;
+    uint32_t count;
+} __attribute__((packed));
+
+struct cmd_proc_scan_summary {
+    uint64_t hits;
+    uint64_t regions;
+    uint64_t bytes;
 } __attribute__((packed));
 
 
@@ -226,6 +472,80 @@ struct cmd_proc_free_packet {
     uint32_t length;
 } __attribute__((packed));
 
+// CMD_PROC_SCAN_OPEN uses struct cmd_proc_scan_packet, SCAN_VAL_STRING is refused
+struct cmd_proc_scan_next_packet {
+    uint8_t compareType;
+    uint32_t lenData;
+} __attribute__((packed));
+
+struct cmd_proc_scan_count_response {
+    uint64_t count;
+} __attribute__((packed));
+
+// followed by count entries of an uint64_t address and the value
+struct cmd_proc_scan_results_packet {
+    uint64_t index;
+    uint32_t count;
+} __attribute__((packed));
+
+// CMD_PROC_SCAN_SET replies with an uint32_t region count and then one of
+// these per region followed by length bytes of the encoded set. Bitmaps have
+// bit n set for the address start + n * stride, deltas are LEB128 distances
+// in strides to the previous candidate (the first one is relative to start),
+// and a region with every slot a candidate sends no set at all
+struct cmd_proc_scan_set_region {
+    uint64_t start;
+    uint64_t count;
+    uint32_t stride;
+    uint8_t encoding;
+    uint64_t length;
+} __attribute__((packed));
+
+// followed by length bytes of the pattern and length bytes of mask, where a
+// 0 in the mask is a wildcard. The matches come back as scan frames
+struct cmd_proc_scan_pattern_packet {
+    uint32_t pid;
+    uint32_t length;
+    uint8_t flags;
+} __attribute__((packed));
+
+// followed by length bytes holding count patterns, each one an uint16_t
+// length, the pattern bytes and the mask
+struct cmd_proc_scan_patterns_packet {
+    uint32_t pid;
+    uint32_t count;
+    uint32_t length;
+} __attribute__((packed));
+
+// one per pattern in the order they were sent, followed by count addresses
+struct cmd_proc_scan_patterns_result {
+    uint32_t index;
+    uint32_t count;
+} __attribute__((packed));
+
+// CMD_PROC_POINTER_MAP replies with a struct cmd_proc_scan_count_response
+struct cmd_proc_pointer_map_packet {
+    uint32_t pid;
+} __attribute__((packed));
+
+// the chains come back as scan frames of struct cmd_proc_pointer_chain
+struct cmd_proc_pointer_scan_packet {
+    uint64_t address;
+    uint32_t maxOffset;
+    uint32_t maxDepth;
+    uint32_t maxResults;
+} __attribute__((packed));
+
+#define POINTER_MAX_DEPTH 8
+
+// [[base + offset] + offsets[0]] ... + offsets[depth - 1] is the address
+struct cmd_proc_pointer_chain {
+    uint64_t base;
+    uint64_t offset;
+    uint32_t depth;
+    uint32_t offsets[POINTER_MAX_DEPTH];
+} __attribute__((packed));
+
 // debug
 struct cmd_debug_attach_packet {
     uint32_t pid;
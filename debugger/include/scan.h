@@ -0,0 +1,75 @@
+#ifndef _SCAN_H
+#define _SCAN_H
+
+#include <ps4.h>
+#include "protocol.h"
+
+#define SCAN_VAL_MAX (SCAN_VAL_STRING + 1)
+#define SCAN_CMP_MAX (SCAN_CMP_UNKNOWN_INITIAL + 1)
+
+#define SCAN_CHUNK_SIZE         0x100000    // default bytes read by a worker at a time
+#define SCAN_MIN_CHUNK_SIZE     PAGE_SIZE
+#define SCAN_MAX_CHUNK_SIZE     0x400000
+#define SCAN_PIECE_SIZE         0x10000     // bytes compared per kernel call
+#define SCAN_MAX_WORKERS        6
+#define SCAN_SLOTS_PER_WORKER   2           // buffers per worker, one is filled while the other waits to be merged
+
+// worst case number of hits a kernel can write for a buffer, plus one slot
+// because the kernels store the offset before deciding if it is a match
+#define SCAN_MAX_HITS(length, stride) (((length) / (stride)) + 1)
+
+// A scan kernel compares every stride aligned value inside of memory against
+// the scan value and writes the byte offset of each match into hits.
+// @param memory: buffer holding the process memory
+// @param length: length of the buffer in bytes
+// @param stride: distance in bytes between two compared values
+// @param value: the value sent by the client
+// @param extra: second value for ranges, or the previous value(s)
+// @param extraStride: 0 when extra is a single value, otherwise how far extra
+//                     advances for every compared value
+// @param valueLength: length of the value (only used by byte arrays)
+// @param hits: receives the offsets, must hold SCAN_MAX_HITS entries
+typedef uint32_t (*scan_kernel_t)(const uint8_t *memory, uint32_t length, uint32_t stride,
+                                  const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                                  uint32_t valueLength, uint32_t *hits);
+
+struct proc_vm_map_entry;
+
+// Receives the results of scan_regions. region is called before each readable
+// map entry is scanned, hits for every buffer that had at least one match with
+// address being the process address of buffer[0] and size the number of bytes
+// in buffer, progress after every chunk with the bytes it covered. Any of them
+// may be NULL, a non zero return stops the scan.
+struct scan_sink {
+    int (*region)(void *arg, struct proc_vm_map_entry *entry);
+    int (*hits)(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count);
+    int (*progress)(void *arg, uint64_t bytes);
+    void *arg;
+};
+
+struct scan_params {
+    uint32_t pid;
+    scan_kernel_t kernel;
+    const uint8_t *value;
+    const uint8_t *extra;
+    uint32_t valueLength;
+    uint32_t stride;
+    uint32_t chunkSize;     // 0 for SCAN_CHUNK_SIZE
+    int system;             // compare in the kdebugger, set by scan_use_system
+    uint32_t valueType;
+    uint32_t compareType;
+};
+
+scan_kernel_t scan_get_kernel(cmd_proc_scan_valuetype valType, cmd_proc_scan_comparetype cmpType);
+// hands the compare to the kdebugger when SCAN_FLAG_SYSTEM asks for it and it
+// can do it, the pages are then compared where they are read and only the
+// hits are copied out, so the buffer the sink gets only holds valid bytes at
+// the hits
+void scan_use_system(struct scan_params *params, cmd_proc_scan_valuetype valType, cmd_proc_scan_comparetype cmpType, uint8_t flags);
+// drops the mappings the filter leaves out and clips the others to its address
+// window, a clipped start stays on the stride from the start of the mapping
+uint64_t scan_filter_maps(const struct cmd_proc_scan_filter *filter, uint32_t stride, struct proc_vm_map_entry *maps, uint64_t num);
+int scan_is_relative(cmd_proc_scan_comparetype cmpType);
+int scan_regions(struct scan_params *params, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink);
+
+#endif
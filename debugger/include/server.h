@@ -11,7 +11,6 @@
 #include "console.h"
 
 #define SERVER_PORT             744
-#define SERVER_MAXCLIENTS       8
 
 #define BROADCAST_PORT          1010
 #define BROADCAST_MAGIC         0xFFFFAAAA
@@ -0,0 +1,108 @@
+#ifndef _SESSION_H
+#define _SESSION_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "scan.h"
+
+#define SESSION_MAX         8
+#define SESSION_READ_SPAN   0x10000 // largest single read while refining
+#define SESSION_BATCH       4096    // candidates compared per kernel call
+#define SESSION_MAX_VALUE   PAGE_SIZE // longest byte array a session compares
+
+// how the candidates of a region are stored (and sent)
+#define SESSION_SET_DELTA   0 // LEB128 encoded distance (in slots) to the previous candidate
+#define SESSION_SET_BITMAP  1 // one bit per slot
+#define SESSION_SET_ALL     2 // every slot, the region is a snapshot
+
+// how a snapshot page is kept
+#define SESSION_PAGE_ZERO   0
+#define SESSION_PAGE_FILL   1 // the same 8 bytes over and over
+#define SESSION_PAGE_RAW    2
+#define SESSION_PAGE_LZ4    3 // LZ4 block of the page
+
+// pages that do not shrink below this are kept raw, not worth expanding
+#define SESSION_LZ4_LIMIT   (PAGE_SIZE * 3 / 4)
+
+// A sorted set of candidate slots, a slot being an index of stride bytes from
+// the start of the region. It starts out delta encoded and switches to a
+// bitmap as soon as that becomes the smaller one.
+struct session_set {
+    uint8_t encoding;
+    uint64_t count;
+    uint64_t last;          // last slot added (delta only)
+    uint64_t length;        // bytes used in data
+    uint64_t capacity;
+    uint8_t *data;
+};
+
+struct session_page {
+    uint8_t type;
+    uint32_t length;        // bytes in data
+    uint64_t fill;
+    uint8_t *data;          // raw and lz4 pages only
+};
+
+struct session_cursor {
+    uint64_t index;         // candidates visited so far
+    uint64_t slot;          // last slot returned
+    uint64_t offset;        // byte offset of the next delta or next bit to test
+};
+
+// candidates that survived inside of one map entry
+struct session_region {
+    uint64_t start;
+    uint64_t end;
+    uint64_t slots;
+    struct session_set set;
+    uint64_t capacity;      // values allocated, in candidates
+    uint8_t *values;        // previous value of every candidate, count * valueLength
+
+    // An unknown initial value scan does not keep candidates, it keeps a copy
+    // of the region instead and every slot is a candidate until the next
+    // refine turns it into a regular set.
+    uint64_t numPages;
+    struct session_page *pages;
+};
+
+// Server side state of a scan, kept per client connection so refining only
+// has to touch the surviving candidates instead of the whole process.
+struct scan_session {
+    int fd;
+    uint32_t pid;
+    uint8_t valueType;
+    uint32_t valueLength;
+    uint32_t stride;
+    uint32_t chunkSize;
+    uint8_t flags;                       // SCAN_FLAG_* of the first scan
+    struct cmd_proc_scan_filter filter;  // mappings the first scan looks at
+    uint64_t count;
+    uint64_t numRegions;
+    uint64_t capRegions;
+    struct session_region *regions;
+
+    // where the last CMD_PROC_SCAN_RESULTS stopped, so paging does not have to
+    // decode the set from the start every time
+    int resultsValid;
+    uint64_t resultsIndex;
+    uint64_t resultsRegion;
+    struct session_cursor resultsCursor;
+
+    // the last lz4 snapshot page results were read from, expanded
+    struct session_page *resultsPage;
+    uint8_t *resultsData;
+};
+
+struct scan_session *session_find(int fd);
+struct scan_session *session_create(int fd, uint32_t pid, uint8_t valueType, uint32_t valueLength);
+void session_free(int fd);
+
+int session_set_next(struct session_set *set, struct session_cursor *cursor, uint64_t *slot);
+uint64_t session_region_count(struct session_region *region);
+
+int session_scan(struct scan_session *session, uint8_t compareType, uint8_t *value, uint8_t *extra);
+// a refine that fails part way leaves the session without candidates
+int session_refine(struct scan_session *session, uint8_t compareType, uint8_t *value, uint8_t *extra);
+uint64_t session_get_results(struct scan_session *session, uint64_t index, uint64_t count, uint8_t *out);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _TEXT_H
+#define _TEXT_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "scan.h"
+
+#define TEXT_MAX_LENGTH     0x400   // encoded bytes
+
+// A string compiled for a Horspool search. The client always sends UTF-8,
+// SCAN_FLAG_UTF16 encodes it as UTF-16LE first. SCAN_FLAG_NOCASE folds the
+// ASCII letters, other characters still have to match exactly.
+struct text_pattern {
+    uint8_t bytes[TEXT_MAX_LENGTH];     // encoded and folded byte by byte
+    uint16_t units[TEXT_MAX_LENGTH / 2]; // UTF-16 units folded one by one
+    uint32_t length;
+    uint32_t unit;                      // 1 for UTF-8, 2 for UTF-16LE
+    int nocase;
+    uint8_t fold[256];
+    uint32_t shift[256];
+};
+
+int text_compile(struct text_pattern *text, const uint8_t *value, uint32_t length, uint8_t flags);
+
+// scan_kernel_t over a compiled string, value points to the struct text_pattern
+uint32_t text_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                     const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                     uint32_t valueLength, uint32_t *hits);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _TRANSFER_H
+#define _TRANSFER_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "net.h"
+#include "lz4.h"
+
+#define TRANSFER_MAX            SERVER_MAXCLIENTS
+#define TRANSFER_DEFAULT_SIZE   0x10000
+#define TRANSFER_MIN_SIZE       NET_MAX_LENGTH
+#define TRANSFER_MAX_SIZE       0x200000
+
+// The buffer a client's reads go through. It is mapped and locked the first
+// time it is needed and kept until the client disconnects, so a read does no
+// allocation and every page is already resident.
+struct transfer_buffer {
+    int fd;
+    uint8_t *data;
+    uint32_t size;          // the chunk size, a multiple of PAGE_SIZE
+    uint32_t flags;
+    uint8_t *packed;        // compressed blocks, size bytes like data
+    uint32_t *table;        // compressor scratch
+};
+
+// the buffer of a client, NULL when it can not be mapped
+struct transfer_buffer *transfer_get(int fd);
+// remaps the buffer with size clamped and rounded up to whole pages, the old
+// buffer is kept when that fails, returns the size in use
+uint32_t transfer_resize(int fd, uint32_t size);
+// returns the TRANSFER_FLAG_* that are in use afterwards
+uint32_t transfer_set_flags(int fd, uint32_t flags);
+void transfer_free(int fd);
+
+// Bulk data in the format the client asked for, plain bytes or blocks of at
+// most size raw bytes. Both return 0 once all length bytes went through.
+int transfer_send(int fd, struct transfer_buffer *transfer, const uint8_t *data, uint32_t length);
+int transfer_recv(int fd, struct transfer_buffer *transfer, uint8_t *data, uint32_t length);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _WATCH_H
+#define _WATCH_H
+
+#include <ps4.h>
+#include "protocol.h"
+#include "net.h"
+
+#define WATCH_MAX           8
+#define WATCH_MAX_ENTRIES   0x400
+#define WATCH_MAX_LENGTH    0x100
+#define WATCH_MIN_INTERVAL  1       // milliseconds
+#define WATCH_IDLE          100000  // longest sleep of the sampler in microseconds
+
+struct watch_entry {
+    uint32_t pid;
+    uint64_t address;
+    uint16_t length;
+    uint64_t interval;      // microseconds
+    uint64_t due;           // process time of the next sample
+    int state;              // 0 before the first sample, 1 readable, 2 unreadable
+    uint8_t *last;          // value pushed last
+};
+
+// The watches of a client and the thread sampling them. Values are only
+// pushed when they changed, batched in one frame per round.
+struct watch_set {
+    int fd;
+    int sock;               // connection back to the client the frames go out on
+    struct watch_entry *entries;
+    uint32_t count;
+    uint8_t *values;        // the last value of every entry
+    uint8_t *frame;         // a round worth of changed values
+    ScePthread thread;
+    int started;
+    volatile int stop;
+    volatile int failed;    // a frame could not be sent
+};
+
+// replaces the watches of a client, none just stops them
+int watch_update(int fd, struct cmd_proc_watch_entry *entries, uint32_t count);
+void watch_free(int fd);
+
+#endif
@@ -0,0 +1,177 @@
+#include "../include/freeze.h"
+
+static struct freeze_entry freezes[FREEZE_MAX_ENTRIES];
+static struct sys_proc_write_v_entry batch[FREEZE_MAX_ENTRIES];
+static uint8_t batched[FREEZE_MAX_ENTRIES];
+static volatile int freezeLock;
+static int freezeStarted;           // only changes under the lock
+static uint32_t freezeNextId;
+static ScePthread freezeThread;
+
+// the table is only held for a round of writes, a spin is enough
+static void freeze_lock() {
+    while (__sync_lock_test_and_set(&freezeLock, 1)) {
+        scePthreadYield();
+    }
+}
+
+static void freeze_unlock() {
+    __sync_lock_release(&freezeLock);
+}
+
+// writes every entry of pid that is due, marks the ones it looked at
+static void freeze_write(uint32_t first, uint64_t now, uint64_t *next) {
+    struct sys_proc_write_v_args args;
+    uint32_t pid = freezes[first].pid;
+    uint32_t count = 0;
+
+    for (uint32_t i = first; i < FREEZE_MAX_ENTRIES; i++) {
+        struct freeze_entry *entry = &freezes[i];
+
+        if (!entry->id || entry->pid != pid) {
+            continue;
+        }
+
+        batched[i] = 1;
+
+        if (entry->due <= now) {
+            batch[count].address = entry->address;
+            batch[count].data = entry->bytes;
+            batch[count].length = entry->length;
+            count++;
+
+            entry->due = now + entry->period * 1000ull;
+        }
+
+        if (entry->due < *next) {
+            *next = entry->due;
+        }
+    }
+
+    if (!count) {
+        return;
+    }
+
+    args.entries = batch;
+    args.count = count;
+    args.failed = 0;
+
+    // only fails when the process is gone
+    if (sys_proc_cmd(pid, SYS_PROC_WRITE_V, &args)) {
+        for (uint32_t i = first; i < FREEZE_MAX_ENTRIES; i++) {
+            if (freezes[i].id && freezes[i].pid == pid) {
+                freezes[i].id = 0;
+            }
+        }
+    }
+}
+
+static void *freeze_thread(void *arg) {
+    while (1) {
+        uint64_t now = sceKernelGetProcessTime();
+        uint64_t next = now + FREEZE_IDLE;
+
+        freeze_lock();
+
+        memset(batched, NULL, sizeof(batched));
+        for (uint32_t i = 0; i < FREEZE_MAX_ENTRIES; i++) {
+            if (freezes[i].id && !batched[i]) {
+                freeze_write(i, now, &next);
+            }
+        }
+
+        freeze_unlock();
+
+        now = sceKernelGetProcessTime();
+        if (next > now) {
+            sceKernelUsleep(next - now);
+        } else {
+            scePthreadYield();
+        }
+    }
+
+    return NULL;
+}
+
+uint32_t freeze_add(uint32_t pid, uint64_t address, const uint8_t *bytes, uint16_t length, uint32_t period) {
+    struct freeze_entry *entry = NULL;
+    uint32_t id = 0;
+
+    if (!length || length > FREEZE_MAX_LENGTH) {
+        return 0;
+    }
+
+    freeze_lock();
+
+    // the thread is started before the first entry goes in, an add that
+    // returns an id can count on something writing it, the new thread just
+    // waits for the lock
+    if (!freezeStarted) {
+        if (scePthreadCreate(&freezeThread, NULL, freeze_thread, NULL, "freeze")) {
+            freeze_unlock();
+            return 0;
+        }
+
+        freezeStarted = 1;
+    }
+
+    for (uint32_t i = 0; i < FREEZE_MAX_ENTRIES && !entry; i++) {
+        if (!freezes[i].id) {
+            entry = &freezes[i];
+        }
+    }
+
+    if (entry) {
+        // ids are not reused while the payload runs
+        id = ++freezeNextId;
+
+        entry->pid = pid;
+        entry->address = address;
+        entry->length = length;
+        entry->period = period < FREEZE_MIN_PERIOD ? FREEZE_MIN_PERIOD : period;
+        entry->due = 0;
+        memcpy(entry->bytes, bytes, length);
+        entry->id = id;
+    }
+
+    freeze_unlock();
+
+    return id;
+}
+
+uint32_t freeze_remove(uint32_t id) {
+    uint32_t removed = 0;
+
+    freeze_lock();
+
+    for (uint32_t i = 0; i < FREEZE_MAX_ENTRIES; i++) {
+        if (freezes[i].id && (!id || freezes[i].id == id)) {
+            freezes[i].id = 0;
+            removed++;
+        }
+    }
+
+    freeze_unlock();
+
+    return removed;
+}
+
+uint32_t freeze_list(struct freeze_entry *entries, uint32_t max) {
+    uint32_t count = 0;
+
+    freeze_lock();
+
+    for (uint32_t i = 0; i < FREEZE_MAX_ENTRIES; i++) {
+        if (freezes[i].id) {
+            if (count < max) {
+                entries[count] = freezes[i];
+            }
+
+            count++;
+        }
+    }
+
+    freeze_unlock();
+
+    return count;
+}
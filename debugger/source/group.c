@@ -0,0 +1,193 @@
+#include "../include/group.h"
+#include "../include/proc.h"
+
+struct group_scan {
+    uint32_t pid;
+    struct scan_group *group;
+    struct scan_sink *sink;
+    uint8_t *window;        // memory around an anchor close to a chunk edge
+    uint32_t *matches;
+    uint32_t capacity;
+};
+
+int group_init(struct scan_group *group, const uint8_t *data, uint32_t length) {
+    uint32_t pos = 0;
+
+    memset(group, NULL, sizeof(struct scan_group));
+
+    while (pos < length) {
+        const struct cmd_proc_scan_group_entry *entry = (const struct cmd_proc_scan_group_entry *)(data + pos);
+        struct group_member *member = &group->members[group->count];
+        uint32_t size;
+
+        if (group->count == GROUP_MAX_MEMBERS || length - pos < CMD_PROC_SCAN_GROUP_ENTRY_SIZE) {
+            return 1;
+        }
+
+        pos += CMD_PROC_SCAN_GROUP_ENTRY_SIZE;
+
+        if (entry->valueType > SCAN_VAL_STRING || !entry->length || entry->length > length - pos ||
+            entry->distance > GROUP_MAX_DISTANCE) {
+            return 1;
+        }
+
+        size = proc_scan_getSizeOfValueType(entry->valueType);
+        if (size && entry->length != size) {
+            return 1;
+        }
+
+        member->valueType = entry->valueType;
+        member->length = entry->length;
+        member->align = size ? size : 1;
+        member->distance = group->count ? entry->distance : 0;
+        member->value = data + pos;
+
+        if (member->distance > group->before) {
+            group->before = member->distance;
+        }
+
+        if (member->distance + member->length > group->after) {
+            group->after = member->distance + member->length;
+        }
+
+        pos += entry->length;
+        group->count++;
+    }
+
+    return !group->count;
+}
+
+// window holds length bytes of the process starting at base
+static int group_matches(const struct scan_group *group, const uint8_t *window, uint64_t base, uint64_t length, uint64_t anchor) {
+    uint64_t anchorEnd = anchor + group->members[0].length;
+
+    for (uint32_t i = 1; i < group->count; i++) {
+        const struct group_member *member = &group->members[i];
+        uint64_t lo = anchor > member->distance ? anchor - member->distance : 0;
+        uint64_t hi = anchor + member->distance;
+        int found = 0;
+
+        lo += (member->align - lo % member->align) % member->align;
+        if (lo < base) {
+            lo = base + (member->align - base % member->align) % member->align;
+        }
+
+        for (uint64_t at = lo; at <= hi && at + member->length <= base + length && !found; at += member->align) {
+            if (at < anchorEnd && at + member->length > anchor) {
+                continue;
+            }
+
+            found = !memcmp(window + (at - base), member->value, member->length);
+        }
+
+        if (!found) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int group_region_handler(void *arg, struct proc_vm_map_entry *entry) {
+    struct group_scan *scan = (struct group_scan *)arg;
+
+    return scan->sink->region ? scan->sink->region(scan->sink->arg, entry) : 0;
+}
+
+static int group_progress_handler(void *arg, uint64_t bytes) {
+    struct group_scan *scan = (struct group_scan *)arg;
+
+    return scan->sink->progress ? scan->sink->progress(scan->sink->arg, bytes) : 0;
+}
+
+static int group_hits_handler(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    struct group_scan *scan = (struct group_scan *)arg;
+    struct scan_group *group = scan->group;
+    uint32_t n = 0;
+
+    if (count > scan->capacity) {
+        uint32_t *matches = (uint32_t *)realloc(scan->matches, count * sizeof(uint32_t));
+        if (!matches) {
+            return 1;
+        }
+
+        scan->matches = matches;
+        scan->capacity = count;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t anchor = address + hits[i];
+        int match;
+
+        if (hits[i] >= group->before && hits[i] + group->after <= size) {
+            match = group_matches(group, buffer, address, size, anchor);
+        } else {
+            // the group reaches past the chunk, read around the anchor and
+            // settle for the chunk when that is not mapped
+            uint64_t start = anchor > group->before ? anchor - group->before : 0;
+            uint64_t length = anchor - start + group->after;
+
+            if (!sys_proc_rw(scan->pid, start, scan->window, length, 0)) {
+                match = group_matches(group, scan->window, start, length, anchor);
+            } else {
+                match = group_matches(group, buffer, address, size, anchor);
+            }
+        }
+
+        if (match) {
+            scan->matches[n++] = hits[i];
+        }
+    }
+
+    if (!n || !scan->sink->hits) {
+        return 0;
+    }
+
+    return scan->sink->hits(scan->sink->arg, address, buffer, size, scan->matches, n);
+}
+
+int group_scan(uint32_t pid, struct scan_group *group, uint32_t stride, uint32_t chunkSize,
+               struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink) {
+    struct group_member *anchor = &group->members[0];
+    struct scan_params params;
+    struct scan_sink inner;
+    struct group_scan scan;
+    int r;
+
+    memset(&scan, NULL, sizeof(scan));
+    scan.pid = pid;
+    scan.group = group;
+    scan.sink = sink;
+
+    scan.window = (uint8_t *)pfmalloc(group->before + group->after);
+    if (!scan.window) {
+        return 1;
+    }
+
+    params.pid = pid;
+    params.kernel = scan_get_kernel(anchor->valueType, SCAN_CMP_EXACT);
+    params.value = anchor->value;
+    params.extra = NULL;
+    params.valueLength = anchor->length;
+    params.stride = stride ? stride : anchor->align;
+    params.chunkSize = chunkSize;
+
+    // the members are looked up in the chunk around each anchor, the kernel
+    // would only hand back the anchors
+    params.system = 0;
+
+    inner.region = group_region_handler;
+    inner.hits = group_hits_handler;
+    inner.progress = group_progress_handler;
+    inner.arg = &scan;
+
+    r = scan_regions(&params, maps, num, &inner);
+
+    free(scan.window);
+
+    if (scan.matches) {
+        free(scan.matches);
+    }
+
+    return r;
+}
@@ -0,0 +1,79 @@
+#include "../include/hash.h"
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t hash_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = hash_rotl(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t hash_merge(uint64_t acc, uint64_t value) {
+    acc ^= hash_round(0, value);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t hash_xxh64(const uint8_t *data, uint64_t length, uint64_t seed) {
+    const uint8_t *end = data + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+
+        do {
+            v1 = hash_round(v1, *(const uint64_t *)data);
+            v2 = hash_round(v2, *(const uint64_t *)(data + 8));
+            v3 = hash_round(v3, *(const uint64_t *)(data + 16));
+            v4 = hash_round(v4, *(const uint64_t *)(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        h = hash_rotl(v1, 1) + hash_rotl(v2, 7) + hash_rotl(v3, 12) + hash_rotl(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += length;
+
+    while (data + 8 <= end) {
+        h ^= hash_round(0, *(const uint64_t *)data);
+        h = hash_rotl(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        data += 8;
+    }
+
+    if (data + 4 <= end) {
+        h ^= (uint64_t)*(const uint32_t *)data * XXH_PRIME64_1;
+        h = hash_rotl(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        data += 4;
+    }
+
+    while (data < end) {
+        h ^= *data * XXH_PRIME64_5;
+        h = hash_rotl(h, 11) * XXH_PRIME64_1;
+        data++;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
@@ -1,17 +1,27 @@
 #include "../include/kdbg.h"
 
+// Touches every page of the range so nothing faults once the kernel writes to it.
+void prefault(void *address, size_t size) {
+    if (!size) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < size; i += PAGE_SIZE) {
+        volatile uint8_t *c = (volatile uint8_t *)address + i;
+        *c = *c;
+    }
+
+    // the last page when the range does not start on a page boundary
+    volatile uint8_t *c = (volatile uint8_t *)address + size - 1;
+    *c = *c;
+}
+
 // A custom malloc wrapper, that will ensure that the allocated memory is prefaulted.
 void *pfmalloc(size_t size) {
     void *p = malloc(size);
     if (p == NULL) return NULL;
 
-    // Prefault() logic directly used here
-    for (uint64_t i = 0; i < size; i++) {
-        volatile uint8_t c;
-        (void)c;
-
-        c = ((char *)p)[i];
-    }
+    prefault(p, size);
 
     return p;
 }
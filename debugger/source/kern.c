@@ -11,6 +11,7 @@ int kern_base_handle(int fd, struct cmd_packet *packet) {
 
 int kern_read_handle(int fd, struct cmd_packet *packet) {
     struct cmd_kern_read_packet *rp;
+    struct transfer_buffer *transfer;
     void *data;
 
     rp = (struct cmd_kern_read_packet *)packet->data;
@@ -22,10 +23,17 @@ int kern_read_handle(int fd, struct cmd_packet *packet) {
             return 1;
         }
 
+        transfer = transfer_get(fd);
+        if (!transfer) {
+            free(data);
+            net_send_status(fd, CMD_DATA_NULL);
+            return 1;
+        }
+
         sys_kern_rw(rp->address, data, rp->length, 0);
 
         net_send_status(fd, CMD_SUCCESS);
-        net_send_data(fd, data, rp->length);
+        transfer_send(fd, transfer, data, rp->length);
         
         free(data);
         return 0;
@@ -38,20 +46,31 @@ int kern_read_handle(int fd, struct cmd_packet *packet) {
 
 int kern_write_handle(int fd, struct cmd_packet *packet) {
     struct cmd_kern_write_packet *wp;
+    struct transfer_buffer *transfer;
     void *data;
 
     wp = (struct cmd_kern_write_packet *)packet->data;
 
     if (wp) {
         data = pfmalloc(wp->length);
-        if (!data) {
+        transfer = transfer_get(fd);
+        if (!data || !transfer) {
+            if (data) {
+                free(data);
+            }
+
             net_send_status(fd, CMD_DATA_NULL);
             return 1;
         }
 
         net_send_status(fd, CMD_SUCCESS);
 
-        net_recv_data(fd, data, wp->length, 1);
+        // nothing is written from a block that did not decode
+        if (transfer_recv(fd, transfer, data, wp->length)) {
+            free(data);
+            return 1;
+        }
+
         sys_kern_rw(wp->address, data, wp->length, 1);
 
         net_send_status(fd, CMD_SUCCESS);
@@ -0,0 +1,201 @@
+#include "../include/lz4.h"
+
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5       // the block always ends with literals
+#define LZ4_MF_LIMIT        12      // no match starts closer to the end
+#define LZ4_MAX_OFFSET      0xFFFF
+
+static inline uint32_t lz4_read32(const uint8_t *p) {
+    return *(const uint32_t *)p;
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline uint8_t *lz4_write_length(uint8_t *op, uint32_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+
+    *op++ = length;
+
+    return op;
+}
+
+static inline void lz4_copy(uint8_t *dst, const uint8_t *src, uint32_t length) {
+    // small copies are most of them, not worth a call
+    if (length > 32) {
+        memcpy(dst, src, length);
+        return;
+    }
+
+    for (uint32_t i = 0; i < length; i++) {
+        dst[i] = src[i];
+    }
+}
+
+// literals and a match, matchLength 0 for the last literals
+static uint8_t *lz4_sequence(uint8_t *op, uint8_t *end, const uint8_t *literals, uint32_t literalLength, uint32_t offset, uint32_t matchLength) {
+    uint8_t *token = op++;
+
+    // worst case for the lengths, the offset and the literals
+    if (op + literalLength + literalLength / 255 + matchLength / 255 + 4 > end) {
+        return NULL;
+    }
+
+    if (literalLength >= 15) {
+        *token = 15 << 4;
+        op = lz4_write_length(op, literalLength - 15);
+    } else {
+        *token = literalLength << 4;
+    }
+
+    lz4_copy(op, literals, literalLength);
+    op += literalLength;
+
+    if (!matchLength) {
+        return op;
+    }
+
+    *op++ = offset;
+    *op++ = offset >> 8;
+
+    matchLength -= LZ4_MIN_MATCH;
+    if (matchLength >= 15) {
+        *token |= 15;
+        op = lz4_write_length(op, matchLength - 15);
+    } else {
+        *token |= matchLength;
+    }
+
+    return op;
+}
+
+uint32_t lz4_compress(const uint8_t *src, uint32_t length, uint8_t *dst, uint32_t capacity, uint32_t *table) {
+    uint8_t *op = dst;
+    uint8_t *end = dst + capacity;
+    uint32_t anchor = 0;
+    uint32_t ip = 0;
+
+    if (length > LZ4_MF_LIMIT) {
+        uint32_t mfLimit = length - LZ4_MF_LIMIT;
+        uint32_t matchLimit = length - LZ4_LAST_LITERALS;
+        uint32_t misses = 0;
+
+        // positions are stored plus one, 0 is an empty slot
+        memset(table, NULL, LZ4_TABLE_SIZE);
+
+        while (ip < mfLimit) {
+            uint32_t sequence = lz4_read32(src + ip);
+            uint32_t h = lz4_hash(sequence);
+            uint32_t ref = table[h];
+            uint32_t matchLength;
+
+            table[h] = ip + 1;
+
+            if (!ref || ip - (ref - 1) > LZ4_MAX_OFFSET || lz4_read32(src + ref - 1) != sequence) {
+                // skip faster through data that does not compress
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+
+            ref--;
+            misses = 0;
+
+            matchLength = LZ4_MIN_MATCH;
+            while (ip + matchLength < matchLimit && src[ip + matchLength] == src[ref + matchLength]) {
+                matchLength++;
+            }
+
+            op = lz4_sequence(op, end, src + anchor, ip - anchor, ip - ref, matchLength);
+            if (!op) {
+                return 0;
+            }
+
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+
+    op = lz4_sequence(op, end, src + anchor, length - anchor, 0, 0);
+    if (!op) {
+        return 0;
+    }
+
+    return op - dst;
+}
+
+static int lz4_read_length(const uint8_t *src, uint32_t length, uint32_t *ip, uint32_t *value) {
+    uint8_t b;
+
+    do {
+        if (*ip >= length) {
+            return 1;
+        }
+
+        b = src[(*ip)++];
+        *value += b;
+    } while (b == 255);
+
+    return 0;
+}
+
+int lz4_decompress(const uint8_t *src, uint32_t length, uint8_t *dst, uint32_t rawLength) {
+    uint32_t ip = 0;
+    uint32_t op = 0;
+
+    while (ip < length) {
+        uint8_t token = src[ip++];
+        uint32_t literalLength = token >> 4;
+        uint32_t matchLength = token & 15;
+        uint32_t offset;
+
+        if (literalLength == 15 && lz4_read_length(src, length, &ip, &literalLength)) {
+            return 1;
+        }
+
+        if (literalLength > length - ip || literalLength > rawLength - op) {
+            return 1;
+        }
+
+        lz4_copy(dst + op, src + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // the last sequence has no match
+        if (ip == length) {
+            break;
+        }
+
+        if (length - ip < 2) {
+            return 1;
+        }
+
+        offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+
+        if (!offset || offset > op) {
+            return 1;
+        }
+
+        if (matchLength == 15 && lz4_read_length(src, length, &ip, &matchLength)) {
+            return 1;
+        }
+
+        matchLength += LZ4_MIN_MATCH;
+        if (matchLength > rawLength - op) {
+            return 1;
+        }
+
+        // the match may overlap what it is copying, byte by byte
+        for (uint32_t i = 0; i < matchLength; i++) {
+            dst[op + i] = dst[op - offset + i];
+        }
+
+        op += matchLength;
+    }
+
+    return op != rawLength;
+}
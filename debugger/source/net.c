@@ -36,7 +36,7 @@ int net_select(int fd, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, str
     return syscall(93, fd, readfds, writefds, exceptfds, timeout);
 }
 
-int net_send_data(int fd, void *data, int length) {
+static int net_write(int fd, void *data, int length, int max) {
     int left = length;
     int offset = 0;
     int sent = 0;
@@ -44,8 +44,8 @@ int net_send_data(int fd, void *data, int length) {
     errno = NULL;
 
     while (left > 0) {
-        if (left > NET_MAX_LENGTH) {
-            sent = write(fd, data + offset, NET_MAX_LENGTH);
+        if (left > max) {
+            sent = write(fd, data + offset, max);
         }
         else {
             sent = write(fd, data + offset, left);
@@ -65,6 +65,16 @@ int net_send_data(int fd, void *data, int length) {
     return offset;
 }
 
+int net_send_data(int fd, void *data, int length) {
+    return net_write(fd, data, length, NET_MAX_LENGTH);
+}
+
+// bulk data goes to the socket in one write, only what the socket did not
+// take is written again
+int net_send_block(int fd, void *data, int length) {
+    return net_write(fd, data, length, length);
+}
+
 int net_recv_data(int fd, void *data, int length, int force) {
     int left = length;
     int offset = 0;
@@ -0,0 +1,288 @@
+#include "../include/pattern.h"
+#include "../include/proc.h"
+
+int pattern_compile(struct pattern *pattern, const uint8_t *bytes, const uint8_t *mask, uint32_t length) {
+    uint32_t first = length;
+    uint32_t last = 0;
+    uint32_t skip;
+
+    for (uint32_t i = 0; i < length; i++) {
+        if (mask[i]) {
+            if (first == length) {
+                first = i;
+            }
+
+            last = i;
+        }
+    }
+
+    // nothing to look for
+    if (first == length) {
+        return 1;
+    }
+
+    pattern->bytes = bytes;
+    pattern->mask = mask;
+    pattern->length = length;
+    pattern->first = first;
+    pattern->last = last;
+
+    // a wildcard matches any byte, so no byte can shift past the last one
+    skip = last - first + 1;
+    for (uint32_t i = first; i < last; i++) {
+        if (!mask[i]) {
+            skip = last - i;
+        }
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        pattern->shift[i] = skip;
+    }
+
+    for (uint32_t i = first; i < last; i++) {
+        if (mask[i] && last - i < pattern->shift[bytes[i]]) {
+            pattern->shift[bytes[i]] = last - i;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t pattern_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                        const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                        uint32_t valueLength, uint32_t *hits) {
+    const struct pattern *pattern = (const struct pattern *)value;
+    const uint8_t *bytes = pattern->bytes;
+    const uint8_t *mask = pattern->mask;
+    uint32_t first = pattern->first;
+    uint32_t last = pattern->last;
+    uint8_t tail = bytes[last];
+    uint32_t count = 0;
+
+    if (length < pattern->length) {
+        return 0;
+    }
+
+    // pos is where the whole pattern (wildcards included) would start
+    for (uint32_t pos = 0; pos <= length - pattern->length; ) {
+        uint8_t c = memory[pos + last];
+
+        if (c == tail) {
+            uint32_t i = first;
+            while (i < last && (!mask[i] || memory[pos + i] == bytes[i])) {
+                i++;
+            }
+
+            if (i == last) {
+                hits[count++] = pos;
+            }
+        }
+
+        pos += pattern->shift[c];
+    }
+
+    return count;
+}
+
+static inline int pattern_matches(const struct pattern *pattern, const uint8_t *memory, uint32_t length, uint32_t pos) {
+    uint32_t span = pattern->last - pattern->first;
+
+    if (pos + span >= length) {
+        return 0;
+    }
+
+    // pos is where the first concrete byte is
+    memory += pos;
+    for (uint32_t i = 1; i <= span; i++) {
+        if (pattern->mask[pattern->first + i] && memory[i] != pattern->bytes[pattern->first + i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static inline int pattern_key_pair(const struct pattern *pattern) {
+    return pattern->first < pattern->last && pattern->mask[pattern->first + 1];
+}
+
+static void pattern_sort_keys(struct pattern_key *keys, uint32_t count) {
+    // insertion sort, the lists are short and built once per command
+    for (uint32_t i = 1; i < count; i++) {
+        struct pattern_key key = keys[i];
+        uint32_t j = i;
+
+        while (j > 0 && keys[j - 1].key > key.key) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+
+        keys[j] = key;
+    }
+}
+
+int pattern_set_init(struct pattern_set *set, struct pattern *patterns, uint32_t count) {
+    memset(set, NULL, sizeof(struct pattern_set));
+    set->patterns = patterns;
+    set->count = count;
+
+    set->pairs = (struct pattern_key *)malloc(count * sizeof(struct pattern_key));
+    set->singles = (struct pattern_key *)malloc(count * sizeof(struct pattern_key));
+    if (!set->pairs || !set->singles) {
+        pattern_set_free(set);
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        struct pattern *pattern = &patterns[i];
+        uint16_t key = pattern->bytes[pattern->first];
+
+        if (pattern->last - pattern->first + 1 > set->span) {
+            set->span = pattern->last - pattern->first + 1;
+        }
+
+        if (pattern_key_pair(pattern)) {
+            key |= pattern->bytes[pattern->first + 1] << 8;
+            set->pairs[set->numPairs].key = key;
+            set->pairs[set->numPairs].index = i;
+            set->numPairs++;
+            set->pairFilter[key >> 6] |= 1ull << (key & 63);
+        } else {
+            set->singles[set->numSingles].key = key;
+            set->singles[set->numSingles].index = i;
+            set->numSingles++;
+            set->singleFilter[key >> 6] |= 1ull << (key & 63);
+        }
+    }
+
+    pattern_sort_keys(set->pairs, set->numPairs);
+    pattern_sort_keys(set->singles, set->numSingles);
+
+    return 0;
+}
+
+void pattern_set_free(struct pattern_set *set) {
+    if (set->pairs) {
+        free(set->pairs);
+    }
+
+    if (set->singles) {
+        free(set->singles);
+    }
+
+    set->pairs = NULL;
+    set->singles = NULL;
+}
+
+static uint32_t pattern_bucket_match(const struct pattern_set *set, const struct pattern_key *keys, uint32_t numKeys, uint16_t key,
+                                     const uint8_t *memory, uint32_t length, uint32_t pos, uint32_t *matches) {
+    uint32_t lo = 0;
+    uint32_t hi = numKeys;
+    uint32_t count = 0;
+
+    // lower bound of key
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (keys[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (; lo < numKeys && keys[lo].key == key; lo++) {
+        if (pattern_matches(&set->patterns[keys[lo].index], memory, length, pos)) {
+            if (!matches) {
+                return 1;
+            }
+
+            matches[count++] = keys[lo].index;
+        }
+    }
+
+    return count;
+}
+
+uint32_t pattern_set_match(const struct pattern_set *set, const uint8_t *memory, uint32_t length, uint32_t pos, uint32_t *matches) {
+    uint16_t single = memory[pos];
+    uint32_t count = 0;
+
+    if (set->singleFilter[single >> 6] & (1ull << (single & 63))) {
+        count = pattern_bucket_match(set, set->singles, set->numSingles, single, memory, length, pos, matches);
+        if (count && !matches) {
+            return count;
+        }
+    }
+
+    if (pos + 1 < length) {
+        uint16_t pair = single | (memory[pos + 1] << 8);
+        if (set->pairFilter[pair >> 6] & (1ull << (pair & 63))) {
+            count += pattern_bucket_match(set, set->pairs, set->numPairs, pair, memory, length, pos, matches ? matches + count : NULL);
+        }
+    }
+
+    return count;
+}
+
+uint32_t pattern_set_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                            const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                            uint32_t valueLength, uint32_t *hits) {
+    const struct pattern_set *set = (const struct pattern_set *)value;
+    uint32_t count = 0;
+
+    for (uint32_t pos = 0; pos < length; pos++) {
+        if (pattern_set_match(set, memory, length, pos, NULL)) {
+            hits[count++] = pos;
+        }
+    }
+
+    return count;
+}
+
+// only the executable mappings are searched, that is where signatures live
+static uint64_t pattern_filter_maps(struct proc_vm_map_entry *maps, uint64_t num) {
+    uint64_t exec = 0;
+
+    for (uint64_t i = 0; i < num; i++) {
+        if (maps[i].prot & PROT_EXEC) {
+            maps[exec++] = maps[i];
+        }
+    }
+
+    return exec;
+}
+
+// maps is filtered in place
+int pattern_scan(uint32_t pid, struct pattern *pattern, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink) {
+    struct scan_params params;
+    uint64_t exec = pattern_filter_maps(maps, num);
+
+    params.pid = pid;
+    params.kernel = pattern_kernel;
+    params.value = (const uint8_t *)pattern;
+    params.extra = NULL;
+    params.valueLength = pattern->length;
+    params.stride = 1;
+    params.chunkSize = 0;
+    params.system = 0;
+
+    return scan_regions(&params, maps, exec, sink);
+}
+
+// maps is filtered in place, the hits are where the first concrete byte of at
+// least one pattern is, use pattern_set_match to find out which
+int pattern_set_scan(uint32_t pid, struct pattern_set *set, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink) {
+    struct scan_params params;
+    uint64_t exec = pattern_filter_maps(maps, num);
+
+    params.pid = pid;
+    params.kernel = pattern_set_kernel;
+    params.value = (const uint8_t *)set;
+    params.extra = NULL;
+    params.valueLength = set->span;
+    params.stride = 1;
+    params.chunkSize = 0;
+    params.system = 0;
+
+    return scan_regions(&params, maps, exec, sink);
+}
@@ -0,0 +1,344 @@
+#include "../include/pointer.h"
+#include "../include/proc.h"
+
+static struct pointer_map pointers[POINTER_MAX];
+
+struct pointer_walk {
+    struct pointer_map *map;
+    uint32_t maxDepth;
+    uint32_t maxOffset;
+    uint64_t maxResults;
+    uint64_t results;
+    uint64_t visits;
+    int stop;
+    pointer_chain_t chain;
+    void *arg;
+    uint32_t offsets[POINTER_MAX_DEPTH];
+};
+
+static void pointer_clear(struct pointer_map *map) {
+    if (map->entries) {
+        free(map->entries);
+    }
+
+    if (map->regions) {
+        free(map->regions);
+    }
+
+    map->entries = NULL;
+    map->count = 0;
+    map->capacity = 0;
+    map->regions = NULL;
+    map->numRegions = 0;
+}
+
+struct pointer_map *pointer_find(int fd) {
+    for (int i = 0; i < POINTER_MAX; i++) {
+        if (pointers[i].fd == fd) {
+            return &pointers[i];
+        }
+    }
+
+    return NULL;
+}
+
+void pointer_free(int fd) {
+    struct pointer_map *map = pointer_find(fd);
+    if (!map) {
+        return;
+    }
+
+    pointer_clear(map);
+
+    memset(map, NULL, sizeof(struct pointer_map));
+}
+
+// the mappings come sorted by address from the kernel
+static struct pointer_region *pointer_find_region(struct pointer_map *map, uint64_t address) {
+    uint64_t lo = 0;
+    uint64_t hi = map->numRegions;
+
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        if (map->regions[mid].start <= address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo && address < map->regions[lo - 1].end) {
+        return &map->regions[lo - 1];
+    }
+
+    return NULL;
+}
+
+static int pointer_hits_handler(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    struct pointer_map *map = (struct pointer_map *)arg;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t value = *(const uint64_t *)(buffer + hits[i]);
+
+        // the kernel only checked the value is between the lowest and highest
+        // mapping, drop what points into the holes
+        if (!pointer_find_region(map, value)) {
+            continue;
+        }
+
+        if (map->count == map->capacity) {
+            uint64_t capacity = map->capacity ? map->capacity * 2 : 0x10000;
+            struct pointer_entry *entries = (struct pointer_entry *)realloc(map->entries, capacity * sizeof(struct pointer_entry));
+            if (!entries) {
+                return 1;
+            }
+
+            map->entries = entries;
+            map->capacity = capacity;
+        }
+
+        map->entries[map->count].value = value;
+        map->entries[map->count].address = address + hits[i];
+        map->count++;
+    }
+
+    return 0;
+}
+
+// LSD radix sort on the value, only on as many 16 bit digits as the values
+// between lo and hi actually use
+static int pointer_sort(struct pointer_map *map, uint64_t lo, uint64_t hi) {
+    struct pointer_entry *src = map->entries;
+    struct pointer_entry *dst;
+    uint32_t *counts;
+
+    if (map->count < 2) {
+        return 0;
+    }
+
+    dst = (struct pointer_entry *)malloc(map->count * sizeof(struct pointer_entry));
+    counts = (uint32_t *)malloc(0x10000 * sizeof(uint32_t));
+    if (!dst || !counts) {
+        if (dst) {
+            free(dst);
+        }
+
+        if (counts) {
+            free(counts);
+        }
+
+        return 1;
+    }
+
+    for (uint32_t shift = 0; shift < 64 && ((hi - lo) >> shift); shift += 16) {
+        uint32_t sum = 0;
+
+        memset(counts, NULL, 0x10000 * sizeof(uint32_t));
+        for (uint64_t i = 0; i < map->count; i++) {
+            counts[((src[i].value - lo) >> shift) & 0xFFFF]++;
+        }
+
+        for (uint32_t i = 0; i < 0x10000; i++) {
+            uint32_t n = counts[i];
+            counts[i] = sum;
+            sum += n;
+        }
+
+        for (uint64_t i = 0; i < map->count; i++) {
+            dst[counts[((src[i].value - lo) >> shift) & 0xFFFF]++] = src[i];
+        }
+
+        struct pointer_entry *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // src holds the sorted entries, whichever buffer that ended up being
+    free(dst);
+    free(counts);
+
+    map->entries = src;
+    map->capacity = map->count;
+
+    return 0;
+}
+
+struct pointer_map *pointer_build(int fd, uint32_t pid) {
+    struct proc_vm_map_entry *maps;
+    struct pointer_map *map;
+    struct scan_params params;
+    struct scan_sink sink;
+    uint64_t num;
+    uint64_t lo;
+    uint64_t hi;
+
+    // a client only has one pointer map, building a new one replaces it
+    map = pointer_find(fd);
+    if (map) {
+        pointer_clear(map);
+    } else {
+        for (int i = 0; i < POINTER_MAX && !map; i++) {
+            if (__sync_bool_compare_and_swap(&pointers[i].fd, 0, fd)) {
+                map = &pointers[i];
+            }
+        }
+
+        if (!map) {
+            return NULL;
+        }
+    }
+
+    map->pid = pid;
+
+    if (proc_get_vm_map(pid, &maps, &num)) {
+        pointer_free(fd);
+        return NULL;
+    }
+
+    map->regions = (struct pointer_region *)malloc(num * sizeof(struct pointer_region));
+    if (!num || !map->regions) {
+        free(maps);
+        pointer_free(fd);
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < num; i++) {
+        struct pointer_region *region = &map->regions[i];
+
+        region->start = maps[i].start;
+        region->end = maps[i].end;
+        region->base = maps[i].start;
+        region->module = 0;
+
+        // images are mapped as several segments with the same name, offsets
+        // are from the first
+        for (uint64_t j = 0; j < i && maps[i].name[0]; j++) {
+            if (!memcmp(maps[j].name, maps[i].name, sizeof(maps[i].name))) {
+                region->base = maps[j].start;
+                break;
+            }
+        }
+    }
+
+    // only executable images are stable roots, named heaps and stacks are not,
+    // one code segment makes every segment of the image a root
+    for (uint64_t i = 0; i < num; i++) {
+        if (!maps[i].name[0] || !(maps[i].prot & PROT_EXEC)) {
+            continue;
+        }
+
+        for (uint64_t j = 0; j < num; j++) {
+            if (map->regions[j].base == map->regions[i].base) {
+                map->regions[j].module = 1;
+            }
+        }
+    }
+
+    map->numRegions = num;
+
+    // the between compare leaves out both bounds
+    lo = maps[0].start - 1;
+    hi = maps[num - 1].end;
+
+    params.pid = pid;
+    params.kernel = scan_get_kernel(SCAN_VAL_U64, SCAN_CMP_BETWEEN);
+    params.value = (const uint8_t *)&lo;
+    params.extra = (const uint8_t *)&hi;
+    params.valueLength = sizeof(uint64_t);
+    params.stride = sizeof(uint64_t);
+    params.chunkSize = 0;
+    params.system = 0;
+
+    sink.region = NULL;
+    sink.hits = pointer_hits_handler;
+    sink.progress = NULL;
+    sink.arg = map;
+
+    if (scan_regions(&params, maps, num, &sink) || pointer_sort(map, lo, hi)) {
+        free(maps);
+        pointer_free(fd);
+        return NULL;
+    }
+
+    free(maps);
+
+    return map;
+}
+
+static int pointer_emit(struct pointer_walk *walk, struct pointer_region *region, uint64_t address, uint32_t depth) {
+    struct cmd_proc_pointer_chain chain;
+
+    memset(&chain, NULL, sizeof(chain));
+    chain.base = region->base;
+    chain.offset = address - region->base;
+    chain.depth = depth + 1;
+
+    // offsets are collected from the target outwards, the client wants them
+    // in the order they are applied
+    for (uint32_t i = 0; i <= depth; i++) {
+        chain.offsets[i] = walk->offsets[depth - i];
+    }
+
+    walk->results++;
+
+    return walk->chain(walk->arg, &chain) || walk->results >= walk->maxResults;
+}
+
+static void pointer_walk(struct pointer_walk *walk, uint64_t target, uint32_t depth) {
+    struct pointer_map *map = walk->map;
+    uint64_t low = target > walk->maxOffset ? target - walk->maxOffset : 0;
+    uint64_t lo = 0;
+    uint64_t hi = map->count;
+
+    // first entry pointing above target
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        if (map->entries[mid].value <= target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // closest pointers first, small offsets are the likely ones
+    for (uint64_t i = lo; i > 0 && map->entries[i - 1].value >= low && !walk->stop; i--) {
+        struct pointer_entry *entry = &map->entries[i - 1];
+        struct pointer_region *region;
+
+        if (++walk->visits > POINTER_MAX_VISITS) {
+            walk->stop = 1;
+            break;
+        }
+
+        walk->offsets[depth] = target - entry->value;
+
+        region = pointer_find_region(map, entry->address);
+        if (region && region->module && pointer_emit(walk, region, entry->address, depth)) {
+            walk->stop = 1;
+            break;
+        }
+
+        if (depth + 1 < walk->maxDepth) {
+            pointer_walk(walk, entry->address, depth + 1);
+        }
+    }
+}
+
+uint64_t pointer_search(struct pointer_map *map, uint64_t target, uint32_t maxDepth, uint32_t maxOffset,
+                        uint64_t maxResults, pointer_chain_t chain, void *arg) {
+    struct pointer_walk walk;
+
+    memset(&walk, NULL, sizeof(walk));
+    walk.map = map;
+    walk.maxDepth = maxDepth > POINTER_MAX_DEPTH ? POINTER_MAX_DEPTH : maxDepth;
+    walk.maxOffset = maxOffset;
+    walk.maxResults = maxResults ? maxResults : (uint64_t)-1;
+    walk.chain = chain;
+    walk.arg = arg;
+
+    if (walk.maxDepth) {
+        pointer_walk(&walk, target, 0);
+    }
+
+    return walk.results;
+}
@@ -1,5 +1,30 @@
 #include "include/proc.h"
 
+// fetches the vm map of a process, the caller has to free maps
+int proc_get_vm_map(uint32_t pid, struct proc_vm_map_entry **maps, uint64_t *num) {
+    struct sys_proc_vm_map_args args;
+
+    memset(&args, NULL, sizeof(struct sys_proc_vm_map_args));
+    if (sys_proc_cmd(pid, SYS_PROC_VM_MAP, &args)) {
+        return 1;
+    }
+
+    args.maps = (struct proc_vm_map_entry *)pfmalloc(args.num * sizeof(struct proc_vm_map_entry));
+    if (!args.maps) {
+        return 1;
+    }
+
+    if (sys_proc_cmd(pid, SYS_PROC_VM_MAP, &args)) {
+        free(args.maps);
+        return 1;
+    }
+
+    *maps = args.maps;
+    *num = args.num;
+
+    return 0;
+}
+
 int proc_list_handle(int fd, struct cmd_packet *packet) {
     void *data;
     uint64_t num;
@@ -32,16 +57,15 @@ int proc_list_handle(int fd, struct cmd_packet *packet) {
 
 int proc_read_handle(int fd, struct cmd_packet *packet) {
     struct cmd_proc_read_packet *rp;
-    void *data;
+    struct transfer_buffer *transfer;
     uint64_t left;
     uint64_t address;
 
     rp = (struct cmd_proc_read_packet *)packet->data;
 
     if(rp) {
-        // allocate a small buffer
-        data = pfmalloc(NET_MAX_LENGTH);
-        if(!data) {
+        transfer = transfer_get(fd);
+        if(!transfer) {
             net_send_status(fd, CMD_DATA_NULL);
             return 1;
         }
@@ -51,76 +75,21 @@ int proc_read_handle(int fd, struct cmd_packet *packet) {
         left = rp->length;
         address = rp->address;
 
-        // send by chunks
+        // send by chunks, only what could not be read is cleared
         while(left > 0) {
-            memset(data, NULL, NET_MAX_LENGTH);
+            uint32_t length = left > transfer->size ? transfer->size : left;
 
-            if(left > NET_MAX_LENGTH) {
-                sys_proc_rw(rp->pid, address, data, NET_MAX_LENGTH, 0);
-                net_send_data(fd, data, NET_MAX_LENGTH);
-
-                address += NET_MAX_LENGTH;
-                left -= NET_MAX_LENGTH;
-            } else {
-                sys_proc_rw(rp->pid, address, data, left, 0);
-                net_send_data(fd, data, left);
-
-                address += left;
-                left -= left;
+            if(sys_proc_rw(rp->pid, address, transfer->data, length, 0)) {
+                memset(transfer->data, NULL, length);
             }
-        }
-
-        free(data);
-
-        return 0;
-    }
-
-    net_send_status(fd, CMD_DATA_NULL);
-    
-    return 1;
-}
-
-int proc_write_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_write_packet *wp;
-    void *data;
-    uint64_t left;
-    uint64_t address;
-
-    wp = (struct cmd_proc_write_packet *)packet->data;
-
-    if(wp) {
-        // only allocate a small buffer
-        data = pfmalloc(NET_MAX_LENGTH);
-        if(!data) {
-            net_send_status(fd, CMD_DATA_NULL);
-            return 1;
-        }
-        
-        net_send_status(fd, CMD_SUCCESS);
-        
-        left = wp->length;
-        address = wp->address;
 
-        // write in chunks
-        while(left > 0) {
-            if(left > NET_MAX_LENGTH) {
-                net_recv_data(fd, data, NET_MAX_LENGTH, 1);
-                sys_proc_rw(wp->pid, address, data, NET_MAX_LENGTH, 1);
-
-                address += NET_MAX_LENGTH;
-                left -= NET_MAX_LENGTH;
-            } else {
-                net_recv_data(fd, data, left, 1);
-                sys_proc_rw(wp->pid, address, data, left, 1);
-
-                address += left;
-                left -= left;
+            if(transfer_send(fd, transfer, transfer->data, length)) {
+                return 1;
             }
-        }
-
-        net_send_status(fd, CMD_SUCCESS);
 
-        free(data);
+            address += length;
+            left -= length;
+        }
 
         return 0;
     }
@@ -130,590 +99,1941 @@ int proc_write_handle(int fd, struct cmd_packet *packet) {
     return 1;
 }
 
-int proc_maps_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_maps_packet *mp;
-    struct sys_proc_vm_map_args args;
-    uint32_t size;
-    uint32_t num;
+int proc_transfer_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_transfer_packet *tp;
+    struct cmd_proc_transfer_response resp;
 
-    mp = (struct cmd_proc_maps_packet *)packet->data;
+    tp = (struct cmd_proc_transfer_packet *)packet->data;
 
-    if(mp) {
-        memset(&args, NULL, sizeof(args));
+    if (!tp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
 
-        if(sys_proc_cmd(mp->pid, SYS_PROC_VM_MAP, &args)) {
-            net_send_status(fd, CMD_ERROR);
-            return 1;
-        }
+    resp.chunkSize = transfer_resize(fd, tp->chunkSize);
+    if (!resp.chunkSize) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
 
-        size = args.num * sizeof(struct proc_vm_map_entry);
+    resp.flags = transfer_set_flags(fd, tp->flags);
 
-        args.maps = (struct proc_vm_map_entry *)pfmalloc(size);
-        if(!args.maps) {
-            net_send_status(fd, CMD_DATA_NULL);
-            return 1;
-        }
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_TRANSFER_RESPONSE_SIZE);
 
-        if(sys_proc_cmd(mp->pid, SYS_PROC_VM_MAP, &args)) {
-            free(args.maps);
-            net_send_status(fd, CMD_ERROR);
-            return 1;
-        }
+    return 0;
+}
 
-        net_send_status(fd, CMD_SUCCESS);
-        num = (uint32_t)args.num;
-        net_send_data(fd, &num, sizeof(uint32_t));
-        net_send_data(fd, args.maps, size);
+#define PROC_READ_V_MAX_ENTRIES 0x1000
+#define PROC_READ_V_MAX_LENGTH  0x400000    // total bytes of one CMD_PROC_READ_V
+#define PROC_READ_V_GAP         0x100       // unwanted bytes read to merge two entries
 
-        free(args.maps);
+// reads one entry straight into its place in the reply
+static uint32_t proc_read_v_entry(uint32_t pid, struct cmd_proc_read_v_entry *entry, uint8_t *out) {
+    if (!entry->length) {
+        return CMD_SUCCESS;
+    }
 
-        return 0;
+    if (sys_proc_rw(pid, entry->address, out, entry->length, 0)) {
+        memset(out, NULL, entry->length);
+        return CMD_ERROR;
     }
-    
-    net_send_status(fd, CMD_ERROR);
-    
-    return 1;
+
+    return CMD_SUCCESS;
 }
 
-int proc_install_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_install_packet *ip;
-    struct sys_proc_install_args args;
-    struct cmd_proc_install_response resp;
+int proc_read_v_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_read_v_packet *rp;
+    struct cmd_proc_read_v_entry *entries;
+    uint32_t *offsets;
+    uint32_t *order;
+    uint32_t *statuses;
+    uint8_t *data;
+    struct transfer_buffer *transfer;
+    uint64_t total;
+    int r = 0;
 
-    ip = (struct cmd_proc_install_packet *)packet->data;
+    rp = (struct cmd_proc_read_v_packet *)packet->data;
 
-    if(!ip) {
+    if (!rp || !rp->count) {
         net_send_status(fd, CMD_DATA_NULL);
         return 1;
     }
 
-    args.stubentryaddr = NULL;
-    sys_proc_cmd(ip->pid, SYS_PROC_INSTALL, &args);
-
-    if(!args.stubentryaddr) {
-        net_send_status(fd, CMD_DATA_NULL);
+    if (rp->count > PROC_READ_V_MAX_ENTRIES) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
         return 1;
     }
 
-    resp.rpcstub = args.stubentryaddr;
+    entries = (struct cmd_proc_read_v_entry *)malloc(rp->count * sizeof(struct cmd_proc_read_v_entry));
+    offsets = (uint32_t *)malloc(rp->count * sizeof(uint32_t));
+    order = (uint32_t *)malloc(rp->count * sizeof(uint32_t));
+    statuses = (uint32_t *)malloc(rp->count * sizeof(uint32_t));
+    transfer = transfer_get(fd);
+    data = NULL;
+    if (!entries || !offsets || !order || !statuses || !transfer) {
+        net_send_status(fd, CMD_DATA_NULL);
+        r = 1;
+        goto finish;
+    }
 
     net_send_status(fd, CMD_SUCCESS);
-    net_send_data(fd, &resp, CMD_PROC_INSTALL_RESPONSE_SIZE);
 
-    return 0;
-}
+    net_recv_data(fd, entries, rp->count * sizeof(struct cmd_proc_read_v_entry), 1);
 
-int proc_call_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_call_packet *cp;
-    struct sys_proc_call_args args;
-    struct cmd_proc_call_response resp;
+    // the reply holds the entries in the order they were sent
+    total = 0;
+    for (uint32_t i = 0; i < rp->count; i++) {
+        offsets[i] = total;
+        total += entries[i].length;
 
-    cp = (struct cmd_proc_call_packet *)packet->data;
+        if (entries[i].address + entries[i].length < entries[i].address) {
+            total = PROC_READ_V_MAX_LENGTH + 1;
+        }
+    }
 
-    if(!cp) {
+    if (total > PROC_READ_V_MAX_LENGTH) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        r = 1;
+        goto finish;
+    }
+
+    data = (uint8_t *)pfmalloc(total ? total : 1);
+    if (!data) {
         net_send_status(fd, CMD_DATA_NULL);
-        return 1;
+        r = 1;
+        goto finish;
     }
 
-    // copy over the arguments for the call
-    args.pid = cp->pid;
-    args.rpcstub = cp->rpcstub;
-    args.rax = NULL;
-    args.rip = cp->rpc_rip;
-    args.rdi = cp->rpc_rdi;
-    args.rsi = cp->rpc_rsi;
-    args.rdx = cp->rpc_rdx;
-    args.rcx = cp->rpc_rcx;
-    args.r8 = cp->rpc_r8;
-    args.r9 = cp->rpc_r9;
+    // insertion sort by address, clients mostly send them sorted already
+    for (uint32_t i = 0; i < rp->count; i++) {
+        uint32_t j = i;
 
-    sys_proc_cmd(cp->pid, SYS_PROC_CALL, &args);
+        while (j > 0 && entries[order[j - 1]].address > entries[i].address) {
+            order[j] = order[j - 1];
+            j--;
+        }
 
-    resp.pid = cp->pid;
-    resp.rpc_rax = args.rax;
+        order[j] = i;
+    }
 
-    net_send_status(fd, CMD_SUCCESS);
-    net_send_data(fd, &resp, CMD_PROC_CALL_RESPONSE_SIZE);
+    for (uint32_t i = 0; i < rp->count; ) {
+        struct cmd_proc_read_v_entry *first = &entries[order[i]];
+        uint64_t start = first->address;
+        uint64_t end = start + first->length;
+        uint32_t next = i + 1;
 
-    return 0;
-}
+        // overlapping and nearby entries are read together into the transfer
+        // buffer, as long as the first one fits
+        while (next < rp->count && end - start <= transfer->size) {
+            struct cmd_proc_read_v_entry *entry = &entries[order[next]];
+            uint64_t entryEnd = entry->address + entry->length;
 
-int proc_elf_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_elf_packet *ep;
-    struct sys_proc_elf_args args;
-    void *elf;
-    
-    ep = (struct cmd_proc_elf_packet *)packet->data;
+            if (entry->address > end + PROC_READ_V_GAP) {
+                break;
+            }
 
-    if(ep) {
-        elf = pfmalloc(ep->length);
-        if(!elf) {
-            net_send_status(fd, CMD_DATA_NULL);
-            return 1;
-        }
+            if (entryEnd > end) {
+                if (entryEnd - start > transfer->size) {
+                    break;
+                }
 
-        net_send_status(fd, CMD_SUCCESS);
+                end = entryEnd;
+            }
 
-        net_recv_data(fd, elf, ep->length, 1);
+            next++;
+        }
 
-        args.elf = elf;
+        if (next - i > 1 && !sys_proc_rw(rp->pid, start, transfer->data, end - start, 0)) {
+            for (uint32_t j = i; j < next; j++) {
+                struct cmd_proc_read_v_entry *entry = &entries[order[j]];
 
-        if(sys_proc_cmd(ep->pid, SYS_PROC_ELF, &args)) {
-            free(elf);
-            net_send_status(fd, CMD_ERROR);
-            return 1;
+                memcpy(data + offsets[order[j]], transfer->data + (entry->address - start), entry->length);
+                statuses[order[j]] = CMD_SUCCESS;
+            }
+        } else {
+            // a merged read fails when a gap is not mapped, the entries may still be
+            for (uint32_t j = i; j < next; j++) {
+                statuses[order[j]] = proc_read_v_entry(rp->pid, &entries[order[j]], data + offsets[order[j]]);
+            }
         }
 
-        free(elf);
+        i = next;
+    }
 
-        net_send_status(fd, CMD_SUCCESS);
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, statuses, rp->count * sizeof(uint32_t));
+    if (total) {
+        net_send_data(fd, data, total);
+    }
 
-        return 0;
+finish:
+    if (entries) {
+        free(entries);
     }
 
-    net_send_status(fd, CMD_ERROR);
-    
-    return 1;
-}
+    if (offsets) {
+        free(offsets);
+    }
 
-int proc_protect_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_protect_packet *pp;
-    struct sys_proc_protect_args args;
+    if (order) {
+        free(order);
+    }
 
-    pp = (struct cmd_proc_protect_packet *)packet->data;
+    if (statuses) {
+        free(statuses);
+    }
 
-    if(pp) {
-        args.address = pp->address;
-        args.length = pp->length;
-        args.prot = pp->newprot;
-        sys_proc_cmd(pp->pid, SYS_PROC_PROTECT, &args);
-        
-        net_send_status(fd, CMD_SUCCESS);
+    if (data) {
+        free(data);
     }
-    
-    net_send_status(fd, CMD_DATA_NULL);
 
-    return 0;
+    return r;
 }
 
-size_t proc_scan_getSizeOfValueType(cmd_proc_scan_valuetype valType) {
-    switch (valType) {
-       case SCAN_VAL_U8:
-       case SCAN_VAL_S8:
-          return 1;
-       case SCAN_VAL_U16:
-       case SCAN_VAL_S16:
-          return 2;
-       case SCAN_VAL_U32:
-       case SCAN_VAL_S32:
-       case SCAN_VAL_FLOAT:
-          return 4;
-       case SCAN_VAL_U64:
-       case SCAN_VAL_S64:
-       case SCAN_VAL_DOUBLE:
-          return 8;
-       case SCAN_VAL_BYTE_ARRAY:
-       case SCAN_VAL_STRING:
-       default:
-          return NULL;
+#define PROC_READ_DELTA_MAX_BLOCKS  0x10000
+
+static int proc_read_delta_send(int fd, uint32_t index, const uint8_t *data, uint32_t length) {
+    struct cmd_proc_read_delta_block block;
+
+    block.index = index;
+    block.length = length;
+
+    if (net_send_data(fd, &block, CMD_PROC_READ_DELTA_BLOCK_SIZE) != CMD_PROC_READ_DELTA_BLOCK_SIZE) {
+        return 1;
     }
-}
 
-bool proc_scan_compareValues(cmd_proc_scan_comparetype cmpType, cmd_proc_scan_valuetype valType, size_t valTypeLength,
-                                 unsigned char *pScanValue, unsigned char *pMemoryValue, unsigned char *pExtraValue) {
-    switch (cmpType) {
-       case SCAN_CMP_EXACT:
-       {
-          bool isFound = false;
-          for (size_t j = 0; j < valTypeLength - 1; j++) {
-             isFound = (pScanValue[j] == pMemoryValue[j]);
-             if (!isFound)
-                break;
-          }
-          return isFound;
-       }
-       case SCAN_CMP_FUZZY:
-       {
-          if (valType == SCAN_VAL_FLOAT) {
-             float diff = *(float *)pScanValue - *(float *)pMemoryValue;
-             return diff < 1.0f && diff > -1.0f;
-          }
-          else if (valType == SCAN_VAL_DOUBLE) {
-             double diff = *(double *)pScanValue - *(double *)pMemoryValue;
-             return diff < 1.0 && diff > -1.0;
-          }
-          else {
-             return false;
-          }
-       }
-       case SCAN_CMP_BIGGER_THAN:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue > *pScanValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue > *(int8_t *)pScanValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue > *(uint16_t *)pScanValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue > *(int16_t *)pScanValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue > *(uint32_t *)pScanValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue > *(int32_t *)pScanValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue > *(uint64_t *)pScanValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue > *(int64_t *)pScanValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue > *(float *)pScanValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue > *(double *)pScanValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_LESS_THAN:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue < *pScanValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue < *(int8_t *)pScanValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue < *(uint16_t *)pScanValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue < *(int16_t *)pScanValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue < *(uint32_t *)pScanValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue < *(int32_t *)pScanValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue < *(uint64_t *)pScanValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue < *(int64_t *)pScanValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue < *(float *)pScanValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue < *(double *)pScanValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_BETWEEN:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                if (*pExtraValue > *pScanValue)
-                   return *pMemoryValue > *pScanValue && *pMemoryValue < *pExtraValue;
-                return *pMemoryValue < *pScanValue && *pMemoryValue > *pExtraValue;
-             case SCAN_VAL_S8:
-                if (*(int8_t *)pExtraValue > *(int8_t *)pScanValue)
-                   return *(int8_t *)pMemoryValue > *(int8_t *)pScanValue && *(int8_t *)pMemoryValue < *(int8_t*)pExtraValue;
-                return *(int8_t *)pMemoryValue < *(int8_t *)pScanValue && *(int8_t *)pMemoryValue > *(int8_t *)pExtraValue;
-             case SCAN_VAL_U16:
-                if (*(uint16_t *)pExtraValue > *(uint16_t *)pScanValue)
-                   return *(uint16_t *)pMemoryValue > *(uint16_t *)pScanValue && *(uint16_t *)pMemoryValue < *(uint16_t*)pExtraValue;
-                return *(uint16_t *)pMemoryValue < *(uint16_t *)pScanValue && *(uint16_t *)pMemoryValue > *(uint16_t *)pExtraValue;
-             case SCAN_VAL_S16:
-                if (*(int16_t *)pExtraValue > *(int16_t *)pScanValue)
-                   return *(int16_t *)pMemoryValue > *(int16_t *)pScanValue && *(int16_t *)pMemoryValue < *(int16_t*)pExtraValue;
-                return *(int16_t *)pMemoryValue < *(int16_t *)pScanValue && *(int16_t *)pMemoryValue > *(int16_t *)pExtraValue;
-             case SCAN_VAL_U32:
-                if (*(uint32_t *)pExtraValue > *(uint32_t *)pScanValue)
-                   return *(uint32_t *)pMemoryValue > *(uint32_t *)pScanValue && *(uint32_t *)pMemoryValue < *(uint32_t*)pExtraValue;
-                return *(uint32_t *)pMemoryValue < *(uint32_t *)pScanValue && *(uint32_t *)pMemoryValue > *(uint32_t *)pExtraValue;
-             case SCAN_VAL_S32:
-                if (*(int32_t *)pExtraValue > *(int32_t *)pScanValue)
-                   return *(int32_t *)pMemoryValue > *(int32_t *)pScanValue && *(int32_t *)pMemoryValue < *(int32_t*)pExtraValue;
-                return *(int32_t *)pMemoryValue < *(int32_t *)pScanValue && *(int32_t *)pMemoryValue > *(int32_t *)pExtraValue;
-             case SCAN_VAL_U64:
-                if (*(uint64_t *)pExtraValue > *(uint64_t *)pScanValue)
-                   return *(uint64_t *)pMemoryValue > *(uint64_t *)pScanValue && *(uint64_t *)pMemoryValue < *(uint64_t*)pExtraValue;
-                return *(uint64_t *)pMemoryValue < *(uint64_t *)pScanValue && *(uint64_t *)pMemoryValue > *(uint64_t *)pExtraValue;
-             case SCAN_VAL_S64:
-                if (*(int64_t *)pExtraValue > *(int64_t *)pScanValue)
-                   return *(int64_t *)pMemoryValue > *(int64_t *)pScanValue && *(int64_t *)pMemoryValue < *(int64_t*)pExtraValue;
-                return *(int64_t *)pMemoryValue < *(int64_t *)pScanValue && *(int64_t *)pMemoryValue > *(int64_t *)pExtraValue;
-             case SCAN_VAL_FLOAT:
-                if (*(float *)pExtraValue > *(float *)pScanValue)
-                   return *(float *)pMemoryValue > *(float *)pScanValue && *(float *)pMemoryValue < *(float*)pExtraValue;
-                return *(float *)pMemoryValue < *(float *)pScanValue && *(float *)pMemoryValue > *(float *)pExtraValue;
-             case SCAN_VAL_DOUBLE:
-                if (*(double *)pExtraValue > *(double *)pScanValue)
-                   return *(double *)pMemoryValue > *(double *)pScanValue && *(double *)pMemoryValue < *(double*)pExtraValue;
-                return *(double *)pMemoryValue < *(double *)pScanValue && *(double *)pMemoryValue > *(double *)pExtraValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_INCREASED:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue > *pExtraValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue > *(int8_t *)pExtraValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue > *(uint16_t *)pExtraValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue > *(int16_t *)pExtraValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue > *(uint32_t *)pExtraValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue > *(int32_t *)pExtraValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue > *(uint64_t *)pExtraValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue > *(int64_t *)pExtraValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue > *(float *)pExtraValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue > *(double *)pExtraValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_INCREASED_BY:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue == (*pExtraValue + *pScanValue);
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue == (*(int8_t *)pExtraValue + *(int8_t *)pScanValue);
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue == (*(uint16_t *)pExtraValue + *(uint16_t *)pScanValue);
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue == (*(int16_t *)pExtraValue + *(int16_t *)pScanValue);
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue == (*(uint32_t *)pExtraValue + *(uint32_t *)pScanValue);
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue == (*(int32_t *)pExtraValue + *(int32_t *)pScanValue);
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue == (*(uint64_t *)pExtraValue + *(uint64_t *)pScanValue);
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue == (*(int64_t *)pExtraValue + *(int64_t *)pScanValue);
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue == (*(float *)pExtraValue + *(float *)pScanValue);
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue == (*(double *)pExtraValue + *(float *)pScanValue);
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_DECREASED:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue < *pExtraValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue < *(int8_t *)pExtraValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue < *(uint16_t *)pExtraValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue < *(int16_t *)pExtraValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue < *(uint32_t *)pExtraValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue < *(int32_t *)pExtraValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue < *(uint64_t *)pExtraValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue < *(int64_t *)pExtraValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue < *(float *)pExtraValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue < *(double *)pExtraValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_DECREASED_BY:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue == (*pExtraValue - *pScanValue);
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue == (*(int8_t *)pExtraValue - *(int8_t *)pScanValue);
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue == (*(uint16_t *)pExtraValue - *(uint16_t *)pScanValue);
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue == (*(int16_t *)pExtraValue - *(int16_t *)pScanValue);
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue == (*(uint32_t *)pExtraValue - *(uint32_t *)pScanValue);
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue == (*(int32_t *)pExtraValue - *(int32_t *)pScanValue);
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue == (*(uint64_t *)pExtraValue - *(uint64_t *)pScanValue);
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue == (*(int64_t *)pExtraValue - *(int64_t *)pScanValue);
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue == (*(float *)pExtraValue - *(float *)pScanValue);
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue == (*(double *)pExtraValue - *(float *)pScanValue);
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_CHANGED:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue != *pExtraValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue != *(int8_t *)pExtraValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue != *(uint16_t *)pExtraValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue != *(int16_t *)pExtraValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue != *(uint32_t *)pExtraValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue != *(int32_t *)pExtraValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue != *(uint64_t *)pExtraValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue != *(int64_t *)pExtraValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue != *(float *)pExtraValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue != *(double *)pExtraValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_UNCHANGED:
-       {
-          switch (valType) {
-             case SCAN_VAL_U8:
-                return *pMemoryValue == *pExtraValue;
-             case SCAN_VAL_S8:
-                return *(int8_t *)pMemoryValue == *(int8_t *)pExtraValue;
-             case SCAN_VAL_U16:
-                return *(uint16_t *)pMemoryValue == *(uint16_t *)pExtraValue;
-             case SCAN_VAL_S16:
-                return *(int16_t *)pMemoryValue == *(int16_t *)pExtraValue;
-             case SCAN_VAL_U32:
-                return *(uint32_t *)pMemoryValue == *(uint32_t *)pExtraValue;
-             case SCAN_VAL_S32:
-                return *(int32_t *)pMemoryValue == *(int32_t *)pExtraValue;
-             case SCAN_VAL_U64:
-                return *(uint64_t *)pMemoryValue == *(uint64_t *)pExtraValue;
-             case SCAN_VAL_S64:
-                return *(int64_t *)pMemoryValue == *(int64_t *)pExtraValue;
-             case SCAN_VAL_FLOAT:
-                return *(float *)pMemoryValue == *(float *)pExtraValue;
-             case SCAN_VAL_DOUBLE:
-                return *(double *)pMemoryValue == *(double *)pExtraValue;
-             case SCAN_VAL_BYTE_ARRAY:
-             case SCAN_VAL_STRING:
-                return false;
-          }
-       }
-       case SCAN_CMP_UNKNOWN_INITIAL:
-       {
-          return true;
-       }
-    }
-    return false;
+    return length && net_send_data(fd, (void *)data, length) != length;
 }
 
-int proc_scan_handle(int fd, struct cmd_packet *packet) {
-    struct cmd_proc_scan_packet *sp = (struct cmd_proc_scan_packet *)packet->data;
+int proc_read_delta_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_read_delta_packet *rp;
+    struct transfer_buffer *transfer;
+    uint64_t *hashes;
+    uint64_t count;
+    uint32_t blockSize;
+    uint32_t span;
 
-    if(!sp) {
+    rp = (struct cmd_proc_read_delta_packet *)packet->data;
+
+    if (!rp || !rp->length) {
         net_send_status(fd, CMD_DATA_NULL);
-       return 1;
+        return 1;
     }
 
-    // get and set data
-    size_t valueLength = proc_scan_getSizeOfValueType(sp->valueType);
-    if (!valueLength) {
-       valueLength = sp->lenData;
-    }
+    blockSize = rp->blockSize ? rp->blockSize : PAGE_SIZE;
+    count = ((uint64_t)rp->length + blockSize - 1) / blockSize;
 
-    unsigned char *data = (unsigned char *)pfmalloc(sp->lenData);
-    if (!data) {
-       net_send_status(fd, CMD_DATA_NULL);
-       return 1;
+    transfer = transfer_get(fd);
+    if (!transfer) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
     }
-    
-    net_send_status(fd, CMD_SUCCESS);
-
-    net_recv_data(fd, data, sp->lenData, 1);
 
-    // query for the process id
-    struct sys_proc_vm_map_args args;
-    memset(&args, NULL, sizeof(struct sys_proc_vm_map_args));
-    if (sys_proc_cmd(sp->pid, SYS_PROC_VM_MAP, &args)) {
-        free(data);
-        net_send_status(fd, CMD_ERROR);
+    // a read covers as many whole blocks as the transfer buffer holds
+    if (count > PROC_READ_DELTA_MAX_BLOCKS || blockSize > transfer->size) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
         return 1;
     }
 
-    size_t size = args.num * sizeof(struct proc_vm_map_entry);
-    args.maps = (struct proc_vm_map_entry *)pfmalloc(size);
-    if (!args.maps) {
-        free(data);
+    hashes = (uint64_t *)malloc(count * sizeof(uint64_t));
+    if (!hashes) {
         net_send_status(fd, CMD_DATA_NULL);
         return 1;
     }
 
-    if (sys_proc_cmd(sp->pid, SYS_PROC_VM_MAP, &args)) {
-        free(args.maps);
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, hashes, count * sizeof(uint64_t), 1);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    span = transfer->size - transfer->size % blockSize;
+
+    for (uint64_t offset = 0; offset < rp->length; offset += span) {
+        uint32_t length = rp->length - offset > span ? span : rp->length - offset;
+        int readable = !sys_proc_rw(rp->pid, rp->address + offset, transfer->data, length, 0);
+
+        for (uint32_t pos = 0; pos < length; pos += blockSize) {
+            uint32_t index = (offset + pos) / blockSize;
+            uint32_t size = length - pos > blockSize ? blockSize : length - pos;
+            uint8_t *block = transfer->data + pos;
+
+            // a span fails as a whole when one of its pages is not mapped
+            if (!readable && sys_proc_rw(rp->pid, rp->address + offset + pos, block, size, 0)) {
+                size = 0;
+            }
+
+            if (size && hash_xxh64(block, size, 0) == hashes[index]) {
+                continue;
+            }
+
+            if (proc_read_delta_send(fd, index, block, size)) {
+                free(hashes);
+                return 1;
+            }
+        }
+    }
+
+    proc_read_delta_send(fd, READ_DELTA_END, NULL, 0);
+
+    free(hashes);
+
+    return 0;
+}
+
+#define PROC_WRITE_CHUNK_SIZE   0x40000     // least bytes received while the previous chunk is written
+#define PROC_WRITE_BUFFERS      2
+
+// Large writes are received and written at the same time, the writer thread
+// follows the receiving one through a ring of buffers.
+struct proc_write_pipe {
+    uint32_t pid;
+    uint64_t address;
+    uint64_t length;
+    uint32_t chunk;
+    uint8_t *buffers[PROC_WRITE_BUFFERS];
+    volatile uint64_t received;     // chunks in the buffers so far
+    volatile uint64_t written;      // chunks written to the process so far
+    volatile int stop;
+};
+
+static void proc_write_chunk(struct proc_write_pipe *pipe, uint64_t i) {
+    uint64_t offset = i * pipe->chunk;
+    uint64_t length = pipe->length - offset;
+
+    if (length > pipe->chunk) {
+        length = pipe->chunk;
+    }
+
+    sys_proc_rw(pipe->pid, pipe->address + offset, pipe->buffers[i % PROC_WRITE_BUFFERS], length, 1);
+}
+
+static void *proc_write_thread(void *arg) {
+    struct proc_write_pipe *pipe = (struct proc_write_pipe *)arg;
+
+    while (1) {
+        uint64_t i = pipe->written;
+
+        if (i == pipe->received) {
+            if (pipe->stop) {
+                break;
+            }
+
+            scePthreadYield();
+            continue;
+        }
+
+        __sync_synchronize();
+
+        proc_write_chunk(pipe, i);
+
+        __sync_synchronize();
+        pipe->written = i + 1;
+    }
+
+    return NULL;
+}
+
+int proc_write_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_write_packet *wp;
+    struct transfer_buffer *transfer;
+    struct proc_write_pipe pipe;
+    ScePthread thread;
+    uint64_t chunks;
+    uint32_t buffers;
+    int threaded;
+    int r = 0;
+
+    wp = (struct cmd_proc_write_packet *)packet->data;
+
+    if (!wp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    transfer = transfer_get(fd);
+    if (!transfer) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    memset(&pipe, NULL, sizeof(pipe));
+    pipe.pid = wp->pid;
+    pipe.address = wp->address;
+    pipe.length = wp->length;
+    // the chunk follows the size set with CMD_PROC_TRANSFER, whole transfer
+    // blocks so compressed ones never straddle two chunks, small sizes are
+    // grouped up to PROC_WRITE_CHUNK_SIZE to keep the syscalls down
+    if (transfer->size < PROC_WRITE_CHUNK_SIZE) {
+        pipe.chunk = PROC_WRITE_CHUNK_SIZE - PROC_WRITE_CHUNK_SIZE % transfer->size;
+    } else {
+        pipe.chunk = transfer->size;
+    }
+
+    chunks = (pipe.length + pipe.chunk - 1) / pipe.chunk;
+    buffers = chunks > 1 ? PROC_WRITE_BUFFERS : 1;
+
+    for (uint32_t i = 0; i < buffers; i++) {
+        pipe.buffers[i] = (uint8_t *)pfmalloc(chunks > 1 ? pipe.chunk : pipe.length + 1);
+        if (!pipe.buffers[i]) {
+            net_send_status(fd, CMD_DATA_NULL);
+            r = 1;
+            goto finish;
+        }
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    // a single chunk has nothing to overlap with, without the thread every
+    // chunk is written before the next one is received
+    threaded = chunks > 1 && !scePthreadCreate(&thread, NULL, proc_write_thread, &pipe, "procwrite");
+
+    for (uint64_t i = 0; i < chunks; i++) {
+        uint64_t length = pipe.length - i * pipe.chunk;
+
+        if (length > pipe.chunk) {
+            length = pipe.chunk;
+        }
+
+        // wait for the buffer to be written out
+        while (threaded && i - pipe.written >= PROC_WRITE_BUFFERS) {
+            scePthreadYield();
+        }
+
+        __sync_synchronize();
+
+        if (transfer_recv(fd, transfer, pipe.buffers[i % buffers], length)) {
+            r = 1;
+            break;
+        }
+
+        if (threaded) {
+            __sync_synchronize();
+            pipe.received = i + 1;
+        } else {
+            proc_write_chunk(&pipe, i);
+        }
+    }
+
+    if (threaded) {
+        pipe.stop = 1;
+        scePthreadJoin(thread, NULL);
+    }
+
+    if (!r) {
+        net_send_status(fd, CMD_SUCCESS);
+    }
+
+finish:
+    for (uint32_t i = 0; i < PROC_WRITE_BUFFERS; i++) {
+        if (pipe.buffers[i]) {
+            free(pipe.buffers[i]);
+        }
+    }
+
+    return r;
+}
+
+#define PROC_WRITE_V_MAX_ENTRIES    0x1000
+#define PROC_WRITE_V_MAX_LENGTH     0x400000    // entries and bytes of one CMD_PROC_WRITE_V
+
+// puts back the original bytes of the patches before index, last one first
+// so overlapping patches end up as they were
+static void proc_write_v_rollback(uint32_t pid, struct cmd_proc_write_v_entry **entries, uint8_t *backup, uint32_t *statuses, uint32_t index) {
+    uint64_t offset = 0;
+
+    for (uint32_t i = 0; i < index; i++) {
+        offset += entries[i]->length;
+    }
+
+    for (uint32_t i = index; i > 0; i--) {
+        struct cmd_proc_write_v_entry *entry = entries[i - 1];
+
+        offset -= entry->length;
+        if (!entry->length || !sys_proc_rw(pid, entry->address, backup + offset, entry->length, 1)) {
+            statuses[i - 1] = CMD_ERROR;
+        }
+    }
+}
+
+int proc_write_v_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_write_v_packet *wp;
+    struct cmd_proc_write_v_entry **entries;
+    uint32_t *statuses;
+    uint8_t *data;
+    uint8_t *backup;
+    uint32_t offset;
+    uint32_t parsed;
+    uint32_t status;
+    int r = 0;
+
+    wp = (struct cmd_proc_write_v_packet *)packet->data;
+
+    if (!wp || !wp->count || !wp->length) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (wp->count > PROC_WRITE_V_MAX_ENTRIES || wp->length > PROC_WRITE_V_MAX_LENGTH) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    data = (uint8_t *)pfmalloc(wp->length);
+    entries = (struct cmd_proc_write_v_entry **)malloc(wp->count * sizeof(struct cmd_proc_write_v_entry *));
+    statuses = (uint32_t *)malloc(wp->count * sizeof(uint32_t));
+    backup = NULL;
+    if (!data || !entries || !statuses) {
+        net_send_status(fd, CMD_DATA_NULL);
+        r = 1;
+        goto finish;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, data, wp->length, 1);
+
+    // everything has to parse before anything is written
+    offset = 0;
+    parsed = 0;
+    while (parsed < wp->count && offset + sizeof(struct cmd_proc_write_v_entry) <= wp->length) {
+        struct cmd_proc_write_v_entry *entry = (struct cmd_proc_write_v_entry *)(data + offset);
+
+        offset += sizeof(struct cmd_proc_write_v_entry);
+        if (entry->length > wp->length - offset) {
+            break;
+        }
+
+        offset += entry->length;
+        entries[parsed] = entry;
+        statuses[parsed] = CMD_ERROR;
+        parsed++;
+    }
+
+    if (parsed != wp->count) {
+        net_send_status(fd, CMD_DATA_NULL);
+        r = 1;
+        goto finish;
+    }
+
+    // the original bytes fit where the patches came in
+    if (wp->flags & WRITE_V_FLAG_ATOMIC) {
+        backup = (uint8_t *)pfmalloc(wp->length);
+        if (!backup) {
+            net_send_status(fd, CMD_DATA_NULL);
+            r = 1;
+            goto finish;
+        }
+
+        offset = 0;
+        for (uint32_t i = 0; i < wp->count; i++) {
+            // nothing is written when a patch can not even be read
+            if (entries[i]->length && sys_proc_rw(wp->pid, entries[i]->address, backup + offset, entries[i]->length, 0)) {
+                net_send_status(fd, CMD_ERROR);
+                net_send_data(fd, statuses, wp->count * sizeof(uint32_t));
+                goto finish;
+            }
+
+            offset += entries[i]->length;
+        }
+    }
+
+    status = CMD_SUCCESS;
+    for (uint32_t i = 0; i < wp->count; i++) {
+        struct cmd_proc_write_v_entry *entry = entries[i];
+
+        if (!entry->length || !sys_proc_rw(wp->pid, entry->address, (uint8_t *)entry + sizeof(struct cmd_proc_write_v_entry), entry->length, 1)) {
+            statuses[i] = CMD_SUCCESS;
+            continue;
+        }
+
+        status = CMD_ERROR;
+
+        if (wp->flags & WRITE_V_FLAG_ATOMIC) {
+            proc_write_v_rollback(wp->pid, entries, backup, statuses, i);
+            break;
+        }
+    }
+
+    net_send_status(fd, status);
+    net_send_data(fd, statuses, wp->count * sizeof(uint32_t));
+
+finish:
+    if (data) {
+        free(data);
+    }
+
+    if (entries) {
+        free(entries);
+    }
+
+    if (statuses) {
+        free(statuses);
+    }
+
+    if (backup) {
+        free(backup);
+    }
+
+    return r;
+}
+
+int proc_watch_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_watch_packet *wp;
+    struct cmd_proc_watch_entry *entries;
+    int r = 0;
+
+    wp = (struct cmd_proc_watch_packet *)packet->data;
+
+    if (!wp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (wp->count > WATCH_MAX_ENTRIES) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    if (!wp->count) {
+        watch_free(fd);
+        net_send_status(fd, CMD_SUCCESS);
+        return 0;
+    }
+
+    entries = (struct cmd_proc_watch_entry *)malloc(wp->count * sizeof(struct cmd_proc_watch_entry));
+    if (!entries) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, entries, wp->count * sizeof(struct cmd_proc_watch_entry), 1);
+
+    for (uint32_t i = 0; i < wp->count; i++) {
+        if (!entries[i].length || entries[i].length > WATCH_MAX_LENGTH) {
+            net_send_status(fd, CMD_DATA_NULL);
+            r = 1;
+            goto finish;
+        }
+    }
+
+    if (watch_update(fd, entries, wp->count)) {
+        net_send_status(fd, CMD_ERROR);
+        r = 1;
+        goto finish;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+finish:
+    free(entries);
+
+    return r;
+}
+
+int proc_freeze_add_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_freeze_add_packet *fp;
+    struct cmd_proc_freeze_add_response resp;
+    uint8_t bytes[FREEZE_MAX_LENGTH];
+
+    fp = (struct cmd_proc_freeze_add_packet *)packet->data;
+
+    if (!fp || !fp->length) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (fp->length > FREEZE_MAX_LENGTH) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, bytes, fp->length, 1);
+
+    resp.id = freeze_add(fp->pid, fp->address, bytes, fp->length, fp->period);
+    if (!resp.id) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_FREEZE_ADD_RESPONSE_SIZE);
+
+    return 0;
+}
+
+int proc_freeze_remove_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_freeze_remove_packet *fp;
+
+    fp = (struct cmd_proc_freeze_remove_packet *)packet->data;
+
+    if (!fp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (!freeze_remove(fp->id) && fp->id) {
+        net_send_status(fd, CMD_INVALID_INDEX);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    return 0;
+}
+
+int proc_freeze_list_handle(int fd, struct cmd_packet *packet) {
+    struct freeze_entry *entries;
+    uint32_t count;
+
+    entries = (struct freeze_entry *)malloc(FREEZE_MAX_ENTRIES * sizeof(struct freeze_entry));
+    if (!entries) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    count = freeze_list(entries, FREEZE_MAX_ENTRIES);
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &count, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        struct cmd_proc_freeze_entry entry;
+
+        entry.id = entries[i].id;
+        entry.pid = entries[i].pid;
+        entry.address = entries[i].address;
+        entry.length = entries[i].length;
+        entry.period = entries[i].period;
+
+        net_send_data(fd, &entry, CMD_PROC_FREEZE_ENTRY_SIZE);
+        net_send_data(fd, entries[i].bytes, entries[i].length);
+    }
+
+    free(entries);
+
+    return 0;
+}
+
+int proc_maps_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_maps_packet *mp;
+    struct sys_proc_vm_map_args args;
+    uint32_t size;
+    uint32_t num;
+
+    mp = (struct cmd_proc_maps_packet *)packet->data;
+
+    if(mp) {
+        memset(&args, NULL, sizeof(args));
+
+        if(sys_proc_cmd(mp->pid, SYS_PROC_VM_MAP, &args)) {
+            net_send_status(fd, CMD_ERROR);
+            return 1;
+        }
+
+        size = args.num * sizeof(struct proc_vm_map_entry);
+
+        args.maps = (struct proc_vm_map_entry *)pfmalloc(size);
+        if(!args.maps) {
+            net_send_status(fd, CMD_DATA_NULL);
+            return 1;
+        }
+
+        if(sys_proc_cmd(mp->pid, SYS_PROC_VM_MAP, &args)) {
+            free(args.maps);
+            net_send_status(fd, CMD_ERROR);
+            return 1;
+        }
+
+        net_send_status(fd, CMD_SUCCESS);
+        num = (uint32_t)args.num;
+        net_send_data(fd, &num, sizeof(uint32_t));
+        net_send_data(fd, args.maps, size);
+
+        free(args.maps);
+
+        return 0;
+    }
+    
+    net_send_status(fd, CMD_ERROR);
+    
+    return 1;
+}
+
+int proc_install_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_install_packet *ip;
+    struct sys_proc_install_args args;
+    struct cmd_proc_install_response resp;
+
+    ip = (struct cmd_proc_install_packet *)packet->data;
+
+    if(!ip) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    args.stubentryaddr = NULL;
+    sys_proc_cmd(ip->pid, SYS_PROC_INSTALL, &args);
+
+    if(!args.stubentryaddr) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    resp.rpcstub = args.stubentryaddr;
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_INSTALL_RESPONSE_SIZE);
+
+    return 0;
+}
+
+int proc_call_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_call_packet *cp;
+    struct sys_proc_call_args args;
+    struct cmd_proc_call_response resp;
+
+    cp = (struct cmd_proc_call_packet *)packet->data;
+
+    if(!cp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    // copy over the arguments for the call
+    args.pid = cp->pid;
+    args.rpcstub = cp->rpcstub;
+    args.rax = NULL;
+    args.rip = cp->rpc_rip;
+    args.rdi = cp->rpc_rdi;
+    args.rsi = cp->rpc_rsi;
+    args.rdx = cp->rpc_rdx;
+    args.rcx = cp->rpc_rcx;
+    args.r8 = cp->rpc_r8;
+    args.r9 = cp->rpc_r9;
+
+    sys_proc_cmd(cp->pid, SYS_PROC_CALL, &args);
+
+    resp.pid = cp->pid;
+    resp.rpc_rax = args.rax;
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_CALL_RESPONSE_SIZE);
+
+    return 0;
+}
+
+int proc_elf_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_elf_packet *ep;
+    struct sys_proc_elf_args args;
+    void *elf;
+    
+    ep = (struct cmd_proc_elf_packet *)packet->data;
+
+    if(ep) {
+        elf = pfmalloc(ep->length);
+        if(!elf) {
+            net_send_status(fd, CMD_DATA_NULL);
+            return 1;
+        }
+
+        net_send_status(fd, CMD_SUCCESS);
+
+        net_recv_data(fd, elf, ep->length, 1);
+
+        args.elf = elf;
+
+        if(sys_proc_cmd(ep->pid, SYS_PROC_ELF, &args)) {
+            free(elf);
+            net_send_status(fd, CMD_ERROR);
+            return 1;
+        }
+
+        free(elf);
+
+        net_send_status(fd, CMD_SUCCESS);
+
+        return 0;
+    }
+
+    net_send_status(fd, CMD_ERROR);
+    
+    return 1;
+}
+
+int proc_protect_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_protect_packet *pp;
+    struct sys_proc_protect_args args;
+
+    pp = (struct cmd_proc_protect_packet *)packet->data;
+
+    if(pp) {
+        args.address = pp->address;
+        args.length = pp->length;
+        args.prot = pp->newprot;
+        sys_proc_cmd(pp->pid, SYS_PROC_PROTECT, &args);
+        
+        net_send_status(fd, CMD_SUCCESS);
+    }
+    
+    net_send_status(fd, CMD_DATA_NULL);
+
+    return 0;
+}
+
+size_t proc_scan_getSizeOfValueType(cmd_proc_scan_valuetype valType) {
+    switch (valType) {
+       case SCAN_VAL_U8:
+       case SCAN_VAL_S8:
+          return 1;
+       case SCAN_VAL_U16:
+       case SCAN_VAL_S16:
+          return 2;
+       case SCAN_VAL_U32:
+       case SCAN_VAL_S32:
+       case SCAN_VAL_FLOAT:
+          return 4;
+       case SCAN_VAL_U64:
+       case SCAN_VAL_S64:
+       case SCAN_VAL_DOUBLE:
+          return 8;
+       case SCAN_VAL_BYTE_ARRAY:
+       case SCAN_VAL_STRING:
+       default:
+          return NULL;
+    }
+}
+
+// a numeric value is sent once, or twice when BETWEEN also needs the upper
+// bound, the compares read valueLength bytes from each without checking
+static int proc_scan_check_length(cmd_proc_scan_valuetype valType, cmd_proc_scan_comparetype cmpType, uint32_t lenData) {
+    size_t valueLength = proc_scan_getSizeOfValueType(valType);
+    if (!valueLength) {
+        return 1;
+    }
+
+    if (cmpType == SCAN_CMP_BETWEEN) {
+        return lenData == valueLength * 2;
+    }
+
+    return lenData == valueLength || lenData == valueLength * 2;
+}
+
+// hits are packed into frames of up to PROC_SCAN_FRAME_LENGTH bytes instead
+// of being written one by one, one send per frame
+#define PROC_SCAN_FRAME_LENGTH 0x10000
+
+// bytes scanned between two progress frames
+#define PROC_SCAN_PROGRESS_LENGTH 0x4000000
+
+struct proc_scan_stream {
+    int fd;
+    uint8_t flags;
+    uint32_t valueLength;
+    uint32_t entryLength;
+    uint32_t count;
+    uint32_t capacity;
+    uint8_t *frame;
+    struct cmd_proc_scan_summary summary;
+    uint64_t reported;      // summary.bytes at the last progress frame
+    int cancelled;
+};
+
+static int proc_scan_flush(struct proc_scan_stream *stream) {
+    struct cmd_proc_scan_frame *header = (struct cmd_proc_scan_frame *)stream->frame;
+    int length;
+
+    if (!stream->count) {
+        return 0;
+    }
+
+    header->type = SCAN_FRAME_HITS;
+    header->count = stream->count;
+
+    length = CMD_PROC_SCAN_FRAME_SIZE + stream->count * stream->entryLength;
+    stream->count = 0;
+
+    // the client is gone, no reason to keep scanning
+    if (net_send_data(stream->fd, stream->frame, length) != length) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static int proc_scan_region_handler(void *arg, struct proc_vm_map_entry *entry) {
+    struct proc_scan_stream *stream = (struct proc_scan_stream *)arg;
+
+    stream->summary.regions++;
+
+    return proc_scan_flush(stream);
+}
+
+// the only packet a client may send during a scan is a cancel, anything else
+// stops the scan as well since the stream can not be resumed after it
+static int proc_scan_cancelled(int fd) {
+    struct cmd_packet packet;
+    struct timeval tv;
+    fd_set sfd;
+
+    memset(&tv, NULL, sizeof(tv));
+    FD_ZERO(&sfd);
+    FD_SET(fd, &sfd);
+    net_select(FD_SETSIZE, &sfd, NULL, NULL, &tv);
+
+    if (!FD_ISSET(fd, &sfd)) {
+        return 0;
+    }
+
+    memset(&packet, NULL, CMD_PACKET_SIZE);
+    net_recv_data(fd, &packet, CMD_PACKET_SIZE, 1);
+
+    if (packet.magic != PACKET_MAGIC || packet.cmd != CMD_PROC_SCAN_CANCEL) {
+        uprintf("unexpected packet %X during scan", packet.cmd);
+    }
+
+    return 1;
+}
+
+static int proc_scan_progress_handler(void *arg, uint64_t bytes) {
+    struct proc_scan_stream *stream = (struct proc_scan_stream *)arg;
+    struct cmd_proc_scan_frame *header = (struct cmd_proc_scan_frame *)stream->frame;
+    int length;
+
+    stream->summary.bytes += bytes;
+
+    if (proc_scan_cancelled(stream->fd)) {
+        stream->cancelled = 1;
+        return 1;
+    }
+
+    if (stream->summary.bytes - stream->reported < PROC_SCAN_PROGRESS_LENGTH) {
+        return 0;
+    }
+
+    // hits first so the counts in the frame match what the client has
+    if (proc_scan_flush(stream)) {
+        return 1;
+    }
+
+    stream->reported = stream->summary.bytes;
+
+    header->type = SCAN_FRAME_PROGRESS;
+    header->count = 0;
+    memcpy(stream->frame + CMD_PROC_SCAN_FRAME_SIZE, &stream->summary, CMD_PROC_SCAN_SUMMARY_SIZE);
+
+    length = CMD_PROC_SCAN_FRAME_SIZE + CMD_PROC_SCAN_SUMMARY_SIZE;
+    if (net_send_data(stream->fd, stream->frame, length) != length) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static int proc_scan_hits_handler(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    struct proc_scan_stream *stream = (struct proc_scan_stream *)arg;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t *entry = stream->frame + CMD_PROC_SCAN_FRAME_SIZE + stream->count * stream->entryLength;
+
+        *(uint64_t *)entry = address + hits[i];
+        if (stream->flags & SCAN_FLAG_VALUES) {
+            memcpy(entry + sizeof(uint64_t), buffer + hits[i], stream->valueLength);
+        }
+
+        if (++stream->count == stream->capacity && proc_scan_flush(stream)) {
+            return 1;
+        }
+    }
+
+    stream->summary.hits += count;
+
+    return 0;
+}
+
+static int proc_stream_open(struct proc_scan_stream *stream, int fd, uint32_t entryLength) {
+    memset(stream, NULL, sizeof(struct proc_scan_stream));
+    stream->fd = fd;
+    stream->entryLength = entryLength;
+    stream->capacity = PROC_SCAN_FRAME_LENGTH / stream->entryLength;
+    if (!stream->capacity) {
+        stream->capacity = 1;
+    }
+
+    stream->frame = (uint8_t *)pfmalloc(CMD_PROC_SCAN_FRAME_SIZE + stream->capacity * stream->entryLength);
+    if (!stream->frame) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static int proc_scan_stream_open(struct proc_scan_stream *stream, int fd, uint8_t flags, uint32_t valueLength) {
+    if (proc_stream_open(stream, fd, sizeof(uint64_t) + (flags & SCAN_FLAG_VALUES ? valueLength : 0))) {
+        return 1;
+    }
+
+    stream->flags = flags;
+    stream->valueLength = valueLength;
+
+    return 0;
+}
+
+// sends what is left and the end frame, which carries the totals so the
+// client can check it got everything, a cancelled scan still sends its hits
+// and a failed one ends with an error frame instead
+static void proc_scan_stream_close(struct proc_scan_stream *stream, int error) {
+    struct cmd_proc_scan_frame *header = (struct cmd_proc_scan_frame *)stream->frame;
+
+    if (!error || stream->cancelled) {
+        proc_scan_flush(stream);
+    }
+
+    if (stream->cancelled) {
+        header->type = SCAN_FRAME_CANCEL;
+    } else {
+        header->type = error ? SCAN_FRAME_ERROR : SCAN_FRAME_END;
+    }
+    header->count = 0;
+    memcpy(stream->frame + CMD_PROC_SCAN_FRAME_SIZE, &stream->summary, CMD_PROC_SCAN_SUMMARY_SIZE);
+    net_send_data(stream->fd, stream->frame, CMD_PROC_SCAN_FRAME_SIZE + CMD_PROC_SCAN_SUMMARY_SIZE);
+
+    free(stream->frame);
+}
+
+// the filter comes before the value, without one every mapping is scanned
+static void proc_scan_recv_filter(int fd, uint8_t flags, struct cmd_proc_scan_filter *filter) {
+    memset(filter, NULL, sizeof(struct cmd_proc_scan_filter));
+
+    if (flags & SCAN_FLAG_FILTER) {
+        net_recv_data(fd, filter, CMD_PROC_SCAN_FILTER_SIZE, 1);
+    }
+}
+
+// a group scan only knows the length of its values once the data is in
+static int proc_scan_group_handle(int fd, struct cmd_proc_scan_packet *sp) {
+    struct cmd_proc_scan_filter filter;
+    struct proc_vm_map_entry *maps;
+    struct proc_scan_stream stream;
+    struct scan_group group;
+    struct scan_sink sink;
+    uint8_t *data;
+    uint64_t num;
+    int r;
+
+    if (!sp->lenData) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    data = (uint8_t *)pfmalloc(sp->lenData);
+    if (!data) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    proc_scan_recv_filter(fd, sp->flags, &filter);
+
+    net_recv_data(fd, data, sp->lenData, 1);
+
+    if (group_init(&group, data, sp->lenData)) {
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (proc_scan_stream_open(&stream, fd, sp->flags, group.members[0].length)) {
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (proc_get_vm_map(sp->pid, &maps, &num)) {
+        free(stream.frame);
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    num = scan_filter_maps(&filter, filter.stride ? filter.stride : group.members[0].align, maps, num);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    uprintf("group scan start");
+
+    sink.region = proc_scan_region_handler;
+    sink.hits = proc_scan_hits_handler;
+    sink.progress = proc_scan_progress_handler;
+    sink.arg = &stream;
+
+    r = group_scan(sp->pid, &group, filter.stride, sp->chunkSize, maps, num, &sink);
+
+    uprintf("group scan done");
+
+    proc_scan_stream_close(&stream, r);
+
+    free(maps);
+    free(data);
+
+    return 0;
+}
+
+int proc_scan_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_packet *sp = (struct cmd_proc_scan_packet *)packet->data;
+
+    if(!sp) {
+        net_send_status(fd, CMD_DATA_NULL);
+       return 1;
+    }
+
+    if (sp->valueType == SCAN_VAL_GROUP) {
+        return proc_scan_group_handle(fd, sp);
+    }
+
+    // get and set data
+    size_t valueLength = proc_scan_getSizeOfValueType(sp->valueType);
+    if (!valueLength) {
+       valueLength = sp->lenData;
+    }
+
+    if (!valueLength || !proc_scan_check_length(sp->valueType, sp->compareType, sp->lenData)) {
+       net_send_status(fd, CMD_DATA_NULL);
+       return 1;
+    }
+
+    unsigned char *data = (unsigned char *)pfmalloc(sp->lenData);
+    if (!data) {
+       net_send_status(fd, CMD_DATA_NULL);
+       return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    struct cmd_proc_scan_filter filter;
+    proc_scan_recv_filter(fd, sp->flags, &filter);
+
+    net_recv_data(fd, data, sp->lenData, 1);
+
+    // strings are searched for one character at a time, the encoding decides
+    // how long the value really is
+    struct text_pattern *text = NULL;
+    uint32_t stride = valueLength;
+    if (sp->valueType == SCAN_VAL_STRING) {
+        text = (struct text_pattern *)malloc(sizeof(struct text_pattern));
+        if (!text || sp->compareType != SCAN_CMP_EXACT || text_compile(text, data, sp->lenData, sp->flags)) {
+            if (text) {
+                free(text);
+            }
+
+            free(data);
+            net_send_status(fd, CMD_ERROR);
+            return 1;
+        }
+
+        valueLength = text->length;
+        stride = text->unit;
+    }
+
+    // pick the specialized compare loop once for the whole scan, not every
+    // compare exists for every type
+    scan_kernel_t kernel = text ? text_kernel : scan_get_kernel(sp->valueType, sp->compareType);
+    if (!kernel) {
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (filter.stride) {
+        stride = filter.stride;
+    }
+
+    struct proc_scan_stream stream;
+    if (proc_scan_stream_open(&stream, fd, sp->flags, valueLength)) {
+        if (text) {
+            free(text);
+        }
+
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    // query for the process id
+    struct proc_vm_map_entry *maps;
+    uint64_t num;
+    if (proc_get_vm_map(sp->pid, &maps, &num)) {
+        if (text) {
+            free(text);
+        }
+
+        free(stream.frame);
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    num = scan_filter_maps(&filter, stride, maps, num);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    uprintf("scan start");
+
+    struct scan_params params;
+    params.pid = sp->pid;
+    params.kernel = kernel;
+    params.value = data;
+    params.extra = valueLength == sp->lenData ? NULL : &data[valueLength];
+    params.valueLength = valueLength;
+    params.stride = stride;
+    params.chunkSize = sp->chunkSize;
+    scan_use_system(&params, sp->valueType, sp->compareType, sp->flags);
+
+    if (text) {
+        params.value = (const uint8_t *)text;
+        params.extra = NULL;
+    }
+
+    struct scan_sink sink;
+    sink.region = proc_scan_region_handler;
+    sink.hits = proc_scan_hits_handler;
+    sink.progress = proc_scan_progress_handler;
+    sink.arg = &stream;
+
+    int r = scan_regions(&params, maps, num, &sink);
+
+    uprintf("scan done");
+
+    proc_scan_stream_close(&stream, r);
+
+    if (text) {
+        free(text);
+    }
+
+    free(maps);
+    free(data);
+
+    return 0;
+}
+
+int proc_scan_pattern_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_pattern_packet *pp;
+    struct proc_vm_map_entry *maps;
+    struct proc_scan_stream stream;
+    struct pattern pattern;
+    struct scan_sink sink;
+    uint8_t *data;
+    uint64_t num;
+    int r;
+
+    pp = (struct cmd_proc_scan_pattern_packet *)packet->data;
+
+    if (!pp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (!pp->length) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (pp->length > PATTERN_MAX_LENGTH) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    data = (uint8_t *)pfmalloc(pp->length * 2);
+    if (!data) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (proc_scan_stream_open(&stream, fd, pp->flags, pp->length)) {
+        free(data);
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, data, pp->length * 2, 1);
+
+    if (pattern_compile(&pattern, data, data + pp->length, pp->length)) {
+        free(stream.frame);
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (proc_get_vm_map(pp->pid, &maps, &num)) {
+        free(stream.frame);
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    sink.region = proc_scan_region_handler;
+    sink.hits = proc_scan_hits_handler;
+    sink.progress = proc_scan_progress_handler;
+    sink.arg = &stream;
+
+    r = pattern_scan(pp->pid, &pattern, maps, num, &sink);
+
+    proc_scan_stream_close(&stream, r);
+
+    free(maps);
+    free(data);
+
+    return 0;
+}
+
+// matches of a multi pattern scan, grouped by pattern
+struct proc_scan_matches {
+    uint64_t *addresses;
+    uint32_t count;
+    uint32_t capacity;
+};
+
+struct proc_scan_patterns {
+    struct pattern_set *set;
+    struct proc_scan_matches *matches;
+    uint32_t *indices;
+    uint64_t start;         // mapping the hits are in
+    uint64_t end;
+};
+
+static int proc_scan_patterns_region_handler(void *arg, struct proc_vm_map_entry *entry) {
+    struct proc_scan_patterns *scan = (struct proc_scan_patterns *)arg;
+
+    scan->start = entry->start;
+    scan->end = entry->end;
+
+    return 0;
+}
+
+static int proc_scan_patterns_handler(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    struct proc_scan_patterns *scan = (struct proc_scan_patterns *)arg;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // the kernel only says something matched here, look up what did
+        uint32_t n = pattern_set_match(scan->set, buffer, size, hits[i], scan->indices);
+
+        for (uint32_t j = 0; j < n; j++) {
+            struct pattern *pattern = &scan->set->patterns[scan->indices[j]];
+            struct proc_scan_matches *matches = &scan->matches[scan->indices[j]];
+            uint64_t hit = address + hits[i];
+
+            // the hit is the first concrete byte, the wildcards around it
+            // still have to be inside the mapping like pattern_kernel makes sure
+            if (hit - scan->start < pattern->first || hit - pattern->first + pattern->length > scan->end) {
+                continue;
+            }
+
+            if (matches->count == matches->capacity) {
+                uint32_t capacity = matches->capacity ? matches->capacity * 2 : 16;
+                uint64_t *addresses = (uint64_t *)realloc(matches->addresses, capacity * sizeof(uint64_t));
+                if (!addresses) {
+                    return 1;
+                }
+
+                matches->addresses = addresses;
+                matches->capacity = capacity;
+            }
+
+            matches->addresses[matches->count++] = hit - pattern->first;
+        }
+    }
+
+    return 0;
+}
+
+int proc_scan_patterns_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_patterns_packet *pp;
+    struct cmd_proc_scan_patterns_result result;
+    struct proc_scan_patterns scan;
+    struct proc_vm_map_entry *maps;
+    struct pattern *patterns;
+    struct pattern_set *set;
+    struct scan_sink sink;
+    uint8_t *data;
+    uint64_t num;
+    uint32_t offset;
+    uint32_t status;
+    int r = 0;
+
+    pp = (struct cmd_proc_scan_patterns_packet *)packet->data;
+
+    if (!pp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (!pp->count || !pp->length) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    if (pp->count > PATTERN_MAX_COUNT || pp->length > PATTERN_MAX_COUNT * (PATTERN_MAX_LENGTH * 2 + sizeof(uint16_t))) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    data = (uint8_t *)pfmalloc(pp->length);
+    patterns = (struct pattern *)malloc(pp->count * sizeof(struct pattern));
+    set = (struct pattern_set *)malloc(sizeof(struct pattern_set));
+    memset(&scan, NULL, sizeof(scan));
+    scan.matches = (struct proc_scan_matches *)calloc(pp->count, sizeof(struct proc_scan_matches));
+    scan.indices = (uint32_t *)malloc(pp->count * sizeof(uint32_t));
+    maps = NULL;
+    if (!data || !patterns || !set || !scan.matches || !scan.indices) {
+        net_send_status(fd, CMD_DATA_NULL);
+        r = 1;
+        goto finish;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    net_recv_data(fd, data, pp->length, 1);
+
+    // everything has to parse before anything is scanned
+    status = CMD_SUCCESS;
+    offset = 0;
+    for (uint32_t i = 0; i < pp->count && status == CMD_SUCCESS; i++) {
+        uint16_t length;
+
+        if (offset + sizeof(uint16_t) > pp->length) {
+            status = CMD_DATA_NULL;
+            break;
+        }
+
+        length = *(uint16_t *)(data + offset);
+        offset += sizeof(uint16_t);
+
+        if (!length || length > PATTERN_MAX_LENGTH || offset + length * 2 > pp->length) {
+            status = CMD_DATA_NULL;
+            break;
+        }
+
+        if (pattern_compile(&patterns[i], data + offset, data + offset + length, length)) {
+            status = CMD_ERROR;
+        }
+
+        offset += length * 2;
+    }
+
+    if (status != CMD_SUCCESS || pattern_set_init(set, patterns, pp->count)) {
+        net_send_status(fd, status != CMD_SUCCESS ? status : CMD_DATA_NULL);
+        r = 1;
+        goto finish;
+    }
+
+    if (proc_get_vm_map(pp->pid, &maps, &num)) {
+        pattern_set_free(set);
+        net_send_status(fd, CMD_ERROR);
+        r = 1;
+        goto finish;
+    }
+
+    scan.set = set;
+
+    sink.region = proc_scan_patterns_region_handler;
+    sink.hits = proc_scan_patterns_handler;
+    sink.progress = NULL;
+    sink.arg = &scan;
+
+    if (pattern_set_scan(pp->pid, set, maps, num, &sink)) {
+        pattern_set_free(set);
+        net_send_status(fd, CMD_ERROR);
+        r = 1;
+        goto finish;
+    }
+
+    pattern_set_free(set);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    for (uint32_t i = 0; i < pp->count; i++) {
+        result.index = i;
+        result.count = scan.matches[i].count;
+
+        net_send_data(fd, &result, CMD_PROC_SCAN_PATTERNS_RESULT_SIZE);
+        if (result.count) {
+            net_send_data(fd, scan.matches[i].addresses, result.count * sizeof(uint64_t));
+        }
+    }
+
+finish:
+    if (scan.matches) {
+        for (uint32_t i = 0; i < pp->count; i++) {
+            if (scan.matches[i].addresses) {
+                free(scan.matches[i].addresses);
+            }
+        }
+
+        free(scan.matches);
+    }
+
+    if (scan.indices) {
+        free(scan.indices);
+    }
+
+    if (maps) {
+        free(maps);
+    }
+
+    if (set) {
+        free(set);
+    }
+
+    if (patterns) {
+        free(patterns);
+    }
+
+    if (data) {
         free(data);
+    }
+
+    return r;
+}
+
+int proc_pointer_map_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_pointer_map_packet *mp;
+    struct cmd_proc_scan_count_response resp;
+    struct pointer_map *map;
+
+    mp = (struct cmd_proc_pointer_map_packet *)packet->data;
+
+    if (!mp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    uprintf("pointer map build");
+
+    map = pointer_build(fd, mp->pid);
+    if (!map) {
         net_send_status(fd, CMD_ERROR);
         return 1;
     }
 
+    resp.count = map->count;
+
     net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_SCAN_COUNT_RESPONSE_SIZE);
 
-    uprintf("scan start");
+    return 0;
+}
 
-    unsigned char *pExtraValue = valueLength == sp->lenData ? NULL : &data[valueLength];
-    unsigned char *scanBuffer = (unsigned char *)pfmalloc(PAGE_SIZE);
-    for (size_t i = 0; i < args.num; i++) {
-       if ((args.maps[i].prot & PROT_READ) != PROT_READ) {
-            continue;
-       }
+static int proc_pointer_chain_handler(void *arg, struct cmd_proc_pointer_chain *chain) {
+    struct proc_scan_stream *stream = (struct proc_scan_stream *)arg;
 
-       uint64_t sectionStartAddr = args.maps[i].start;
-       size_t sectionLen = args.maps[i].end - sectionStartAddr;
+    memcpy(stream->frame + CMD_PROC_SCAN_FRAME_SIZE + stream->count * stream->entryLength, chain, CMD_PROC_POINTER_CHAIN_SIZE);
+    stream->summary.hits++;
 
-       // scan
-       for (uint64_t j = 0; j < sectionLen; j += valueLength) {
-            if(j == 0 || !(j % PAGE_SIZE)) {
-                sys_proc_rw(sp->pid, sectionStartAddr, scanBuffer, PAGE_SIZE, 0);
-            }
+    if (++stream->count == stream->capacity) {
+        return proc_scan_flush(stream);
+    }
 
-            uint64_t scanOffset = j % PAGE_SIZE;
-            uint64_t curAddress = sectionStartAddr + j;
-            if (proc_scan_compareValues(sp->compareType, sp->valueType, valueLength, data, scanBuffer + scanOffset, pExtraValue)) {
-                net_send_data(fd, &curAddress, sizeof(uint64_t));
-            }
-       }
+    return 0;
+}
+
+int proc_pointer_scan_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_pointer_scan_packet *sp;
+    struct proc_scan_stream stream;
+    struct pointer_map *map;
+
+    sp = (struct cmd_proc_pointer_scan_packet *)packet->data;
+
+    if (!sp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
     }
 
-    uprintf("scan done");
+    map = pointer_find(fd);
+    if (!map) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (proc_stream_open(&stream, fd, CMD_PROC_POINTER_CHAIN_SIZE)) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    pointer_search(map, sp->address, sp->maxDepth, sp->maxOffset, sp->maxResults, proc_pointer_chain_handler, &stream);
+
+    proc_scan_stream_close(&stream, 0);
+
+    return 0;
+}
+
+int proc_pointer_close_handle(int fd, struct cmd_packet *packet) {
+    pointer_free(fd);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    return 0;
+}
+
+int proc_scan_open_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_packet *sp;
+    struct cmd_proc_scan_count_response resp;
+    struct cmd_proc_scan_filter filter;
+    struct scan_session *session;
+    uint32_t valueLength;
+    uint8_t *data;
+
+    sp = (struct cmd_proc_scan_packet *)packet->data;
+
+    if (!sp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    // strings are only searched by CMD_PROC_SCAN, a session compares values of
+    // one length at fixed slots and would ignore the encoding and case flags
+    if (sp->valueType == SCAN_VAL_STRING) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    valueLength = proc_scan_getSizeOfValueType(sp->valueType);
+    if (!valueLength) {
+        valueLength = sp->lenData;
+    }
+
+    if (!valueLength || !proc_scan_check_length(sp->valueType, sp->compareType, sp->lenData)) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    // a batch of values is SESSION_BATCH * valueLength bytes
+    if (valueLength > SESSION_MAX_VALUE) {
+        net_send_status(fd, CMD_TOO_MUCH_DATA);
+        return 1;
+    }
+
+    data = (uint8_t *)pfmalloc(sp->lenData);
+    if (!data) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    proc_scan_recv_filter(fd, sp->flags, &filter);
+
+    net_recv_data(fd, data, sp->lenData, 1);
+
+    session = session_create(fd, sp->pid, sp->valueType, valueLength);
+    if (!session) {
+        free(data);
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    session->chunkSize = sp->chunkSize;
+    session->flags = sp->flags;
+    session->filter = filter;
+    if (filter.stride) {
+        session->stride = filter.stride;
+    }
+
+    uprintf("scan session open");
+
+    if (session_scan(session, sp->compareType, data, valueLength == sp->lenData ? NULL : &data[valueLength])) {
+        session_free(fd);
+        free(data);
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    free(data);
+
+    resp.count = session->count;
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_SCAN_COUNT_RESPONSE_SIZE);
+
+    return 0;
+}
+
+int proc_scan_next_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_next_packet *np;
+    struct cmd_proc_scan_count_response resp;
+    struct scan_session *session;
+    uint8_t *data;
+    uint8_t *value;
+    uint8_t *extra;
+
+    np = (struct cmd_proc_scan_next_packet *)packet->data;
+
+    if (!np) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    session = session_find(fd);
+    if (!session) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    data = NULL;
+    if (np->lenData) {
+        data = (uint8_t *)pfmalloc(np->lenData);
+        if (!data) {
+            net_send_status(fd, CMD_DATA_NULL);
+            return 1;
+        }
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    if (data) {
+        net_recv_data(fd, data, np->lenData, 1);
+    }
+
+    // the compare may need no value at all (changed, unchanged, ...)
+    value = np->lenData >= session->valueLength ? data : NULL;
+    extra = np->lenData >= session->valueLength * 2 ? data + session->valueLength : NULL;
+
+    if (session_refine(session, np->compareType, value, extra)) {
+        if (data) {
+            free(data);
+        }
+
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    if (data) {
+        free(data);
+    }
+
+    resp.count = session->count;
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &resp, CMD_PROC_SCAN_COUNT_RESPONSE_SIZE);
+
+    return 0;
+}
+
+int proc_scan_results_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_results_packet *rp;
+    struct scan_session *session;
+    uint64_t index;
+    uint32_t count;
+    uint32_t entry;
+    uint8_t *data;
+
+    rp = (struct cmd_proc_scan_results_packet *)packet->data;
+
+    if (!rp) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    session = session_find(fd);
+    if (!session) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    entry = sizeof(uint64_t) + session->valueLength;
+    data = (uint8_t *)pfmalloc(SESSION_BATCH * entry);
+    if (!data) {
+        net_send_status(fd, CMD_DATA_NULL);
+        return 1;
+    }
+
+    count = rp->count;
+    if (rp->index >= session->count) {
+        count = 0;
+    } else if (count > session->count - rp->index) {
+        count = session->count - rp->index;
+    }
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &count, sizeof(uint32_t));
+
+    // send by batches, the count is already out so a short batch (a page that
+    // could not be expanded) is padded with zeroed entries, address 0 is never a hit
+    index = rp->index;
+    while (count > 0) {
+        uint32_t want = count > SESSION_BATCH ? SESSION_BATCH : count;
+        uint64_t n = session_get_results(session, index, want, data);
+        if (n < want) {
+            memset(data + n * entry, NULL, (want - n) * entry);
+        }
+
+        net_send_data(fd, data, want * entry);
 
-    uint64_t endflag = 0xFFFFFFFFFFFFFFFF;
-    net_send_data(fd, &endflag, sizeof(uint64_t));
+        index += want;
+        count -= want;
+    }
 
-    free(scanBuffer);
-    free(args.maps);
     free(data);
 
     return 0;
 }
 
+int proc_scan_close_handle(int fd, struct cmd_packet *packet) {
+    session_free(fd);
+
+    net_send_status(fd, CMD_SUCCESS);
+
+    return 0;
+}
+
+int proc_scan_set_handle(int fd, struct cmd_packet *packet) {
+    struct cmd_proc_scan_set_region header;
+    struct scan_session *session;
+    uint32_t num;
+
+    session = session_find(fd);
+    if (!session) {
+        net_send_status(fd, CMD_ERROR);
+        return 1;
+    }
+
+    num = (uint32_t)session->numRegions;
+
+    net_send_status(fd, CMD_SUCCESS);
+    net_send_data(fd, &num, sizeof(uint32_t));
+
+    // the sets go out as they are stored, the client decodes them itself
+    for (uint32_t i = 0; i < num; i++) {
+        struct session_region *region = &session->regions[i];
+
+        header.start = region->start;
+        header.count = session_region_count(region);
+        header.stride = session->stride;
+        header.encoding = region->pages ? SESSION_SET_ALL : region->set.encoding;
+        header.length = region->pages ? 0 : region->set.length;
+
+        net_send_data(fd, &header, CMD_PROC_SCAN_SET_REGION_SIZE);
+        if (header.length) {
+            net_send_data(fd, region->set.data, header.length);
+        }
+    }
+
+    return 0;
+}
+
 int proc_info_handle(int fd, struct cmd_packet *packet) {
     struct cmd_proc_info_packet *ip;
     struct sys_proc_info_args args;
@@ -789,8 +2109,24 @@ int proc_handle(int fd, struct cmd_packet *packet) {
             return proc_list_handle(fd, packet);
         case CMD_PROC_READ:
             return proc_read_handle(fd, packet);
+        case CMD_PROC_READ_V:
+            return proc_read_v_handle(fd, packet);
+        case CMD_PROC_READ_DELTA:
+            return proc_read_delta_handle(fd, packet);
         case CMD_PROC_WRITE:
             return proc_write_handle(fd, packet);
+        case CMD_PROC_WRITE_V:
+            return proc_write_v_handle(fd, packet);
+        case CMD_PROC_TRANSFER:
+            return proc_transfer_handle(fd, packet);
+        case CMD_PROC_WATCH:
+            return proc_watch_handle(fd, packet);
+        case CMD_PROC_FREEZE_ADD:
+            return proc_freeze_add_handle(fd, packet);
+        case CMD_PROC_FREEZE_REMOVE:
+            return proc_freeze_remove_handle(fd, packet);
+        case CMD_PROC_FREEZE_LIST:
+            return proc_freeze_list_handle(fd, packet);
         case CMD_PROC_MAPS:
             return proc_maps_handle(fd, packet);
         case CMD_PROC_INTALL:
@@ -809,6 +2145,29 @@ int proc_handle(int fd, struct cmd_packet *packet) {
             return proc_alloc_handle(fd, packet);
         case CMD_PROC_FREE:
             return proc_free_handle(fd, packet);
+        case CMD_PROC_SCAN_OPEN:
+            return proc_scan_open_handle(fd, packet);
+        case CMD_PROC_SCAN_NEXT:
+            return proc_scan_next_handle(fd, packet);
+        case CMD_PROC_SCAN_RESULTS:
+            return proc_scan_results_handle(fd, packet);
+        case CMD_PROC_SCAN_CLOSE:
+            return proc_scan_close_handle(fd, packet);
+        case CMD_PROC_SCAN_SET:
+            return proc_scan_set_handle(fd, packet);
+        case CMD_PROC_SCAN_PATTERN:
+            return proc_scan_pattern_handle(fd, packet);
+        case CMD_PROC_SCAN_PATTERNS:
+            return proc_scan_patterns_handle(fd, packet);
+        case CMD_PROC_POINTER_MAP:
+            return proc_pointer_map_handle(fd, packet);
+        case CMD_PROC_POINTER_SCAN:
+            return proc_pointer_scan_handle(fd, packet);
+        case CMD_PROC_POINTER_CLOSE:
+            return proc_pointer_close_handle(fd, packet);
+        case CMD_PROC_SCAN_CANCEL:
+            // the scan it was meant for already ended
+            return 0;
     }
 
     return 1;
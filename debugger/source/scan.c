@@ -0,0 +1,757 @@
+#include "../include/scan.h"
+#include "../include/proc.h"
+
+// The kernels below are generated once per (value type, compare type) pair so
+// the scan loop never has to look at the compare or value type again. Every
+// kernel stores the offset first and only advances the hit counter when the
+// compare succeeds, this keeps the loops free of unpredictable branches.
+
+#define SCAN_KERNEL_ARGS const uint8_t *memory, uint32_t length, uint32_t stride, \
+                         const uint8_t *value, const uint8_t *extra, uint32_t extraStride, \
+                         uint32_t valueLength, uint32_t *hits
+
+// compares memory against the scan value (v) and an optional second value (x)
+#define SCAN_KERNEL_VALUE(name, type, cond) \
+static uint32_t name(SCAN_KERNEL_ARGS) { \
+    const type v = *(const type *)value; \
+    const type x = extra ? *(const type *)extra : v; \
+    const type lo = x > v ? v : x; \
+    const type hi = x > v ? x : v; \
+    uint32_t count = 0; \
+    (void)lo; (void)hi; \
+    if (length < sizeof(type)) \
+        return 0; \
+    for (uint32_t off = 0; off <= length - sizeof(type); off += stride) { \
+        const type m = *(const type *)(memory + off); \
+        hits[count] = off; \
+        count += (cond); \
+    } \
+    return count; \
+}
+
+// compares memory against the previous value(s) (e), t is derived from e and
+// the scan value (v) so the compare is always a single operator
+#define SCAN_KERNEL_PREVIOUS(name, type, texpr, op) \
+static uint32_t name(SCAN_KERNEL_ARGS) { \
+    const type v = value ? *(const type *)value : 0; \
+    uint32_t count = 0; \
+    (void)v; \
+    if (length < sizeof(type) || !extra) \
+        return 0; \
+    for (uint32_t off = 0; off <= length - sizeof(type); off += stride, extra += extraStride) { \
+        const type m = *(const type *)(memory + off); \
+        const type e = *(const type *)extra; \
+        const type t = texpr; \
+        hits[count] = off; \
+        count += (m op t); \
+    } \
+    return count; \
+}
+
+#if defined(__SSE4_2__)
+#define SCAN_SIMD_INTEGER 1
+#endif
+
+#if defined(__AVX__)
+#define SCAN_SIMD_FLOAT 1
+#endif
+
+#if defined(SCAN_SIMD_INTEGER) || defined(SCAN_SIMD_FLOAT)
+// The vector kernels compare a whole register of values at once and turn the
+// result into a bitmask, only set bits are visited. They need the values to be
+// packed (stride equal to the value size), anything else and the remaining
+// tail of the buffer is handed to the scalar kernel.
+
+typedef char v16qi __attribute__((vector_size(16)));
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+typedef int8_t v16s8 __attribute__((vector_size(16)));
+typedef uint16_t v8u16 __attribute__((vector_size(16)));
+typedef int16_t v8s16 __attribute__((vector_size(16)));
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+typedef int32_t v4s32 __attribute__((vector_size(16)));
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+typedef int64_t v2s64 __attribute__((vector_size(16)));
+typedef float v8sf __attribute__((vector_size(32)));
+typedef double v4df __attribute__((vector_size(32)));
+
+// pmovmskb yields one bit per byte, only keep the first byte of each element
+// so the bit index is the byte offset of the value
+#define SCAN_MASK_8(c)  ((uint32_t)__builtin_ia32_pmovmskb128((v16qi)(c)))
+#define SCAN_MASK_16(c) (SCAN_MASK_8(c) & 0x5555)
+#define SCAN_MASK_32(c) (SCAN_MASK_8(c) & 0x1111)
+#define SCAN_MASK_64(c) (SCAN_MASK_8(c) & 0x0101)
+
+// movmskps/movmskpd yield one bit per element
+#define SCAN_MASK_FLOAT(c)  ((uint32_t)__builtin_ia32_movmskps256((v8sf)(c)))
+#define SCAN_MASK_DOUBLE(c) ((uint32_t)__builtin_ia32_movmskpd256((v4df)(c)))
+
+static inline uint32_t scan_simd_hits(uint32_t mask, uint32_t off, uint32_t scale, uint32_t *hits) {
+    uint32_t count = 0;
+
+    while (mask) {
+        hits[count++] = off + __builtin_ctz(mask) * scale;
+        mask &= mask - 1;
+    }
+
+    return count;
+}
+
+// runs the scalar kernel from off to the end of the buffer
+static inline uint32_t scan_simd_tail(scan_kernel_t scalar, uint32_t off, SCAN_KERNEL_ARGS) {
+    uint32_t count;
+
+    if (off >= length)
+        return 0;
+
+    if (extra && extraStride)
+        extra += (off / stride) * extraStride;
+
+    count = scalar(memory + off, length - off, stride, value, extra, extraStride, valueLength, hits);
+    for (uint32_t i = 0; i < count; i++)
+        hits[i] += off;
+
+    return count;
+}
+
+#define SCAN_SIMD_VALUE(name, type, vtype, mask, scale, cond) \
+static uint32_t name##_simd(SCAN_KERNEL_ARGS) { \
+    const type v = *(const type *)value; \
+    const type x = extra ? *(const type *)extra : v; \
+    const type lo = x > v ? v : x; \
+    const type hi = x > v ? x : v; \
+    uint32_t count = 0; \
+    uint32_t off = 0; \
+    (void)lo; (void)hi; \
+    if (stride == sizeof(type)) { \
+        for (; off + sizeof(vtype) <= length; off += sizeof(vtype)) { \
+            vtype m; \
+            __builtin_memcpy(&m, memory + off, sizeof(vtype)); \
+            count += scan_simd_hits(mask(cond), off, scale, hits + count); \
+        } \
+    } \
+    return count + scan_simd_tail(name, off, memory, length, stride, value, extra, extraStride, valueLength, hits + count); \
+}
+
+#define SCAN_SIMD_PREVIOUS(name, type, vtype, mask, scale, texpr, op) \
+static uint32_t name##_simd(SCAN_KERNEL_ARGS) { \
+    const type v = value ? *(const type *)value : 0; \
+    uint32_t count = 0; \
+    uint32_t off = 0; \
+    (void)v; \
+    if (stride == sizeof(type) && extraStride == sizeof(type) && extra) { \
+        for (; off + sizeof(vtype) <= length; off += sizeof(vtype)) { \
+            vtype m; \
+            vtype e; \
+            __builtin_memcpy(&m, memory + off, sizeof(vtype)); \
+            __builtin_memcpy(&e, extra + off, sizeof(vtype)); \
+            const vtype t = texpr; \
+            count += scan_simd_hits(mask(m op t), off, scale, hits + count); \
+        } \
+    } \
+    return count + scan_simd_tail(name, off, memory, length, stride, value, extra, extraStride, valueLength, hits + count); \
+}
+
+#define SCAN_KERNEL_PAIR_VALUE(name, type, vtype, mask, scale, cond) \
+    SCAN_KERNEL_VALUE(name, type, cond) \
+    SCAN_SIMD_VALUE(name, type, vtype, mask, scale, cond)
+
+#define SCAN_KERNEL_PAIR_PREVIOUS(name, type, vtype, mask, scale, texpr, op) \
+    SCAN_KERNEL_PREVIOUS(name, type, texpr, op) \
+    SCAN_SIMD_PREVIOUS(name, type, vtype, mask, scale, texpr, op)
+#endif
+
+#define SCAN_KERNELS_SCALAR(suffix, type) \
+    SCAN_KERNEL_VALUE(scan_exact_##suffix, type, m == v) \
+    SCAN_KERNEL_VALUE(scan_bigger_##suffix, type, m > v) \
+    SCAN_KERNEL_VALUE(scan_less_##suffix, type, m < v) \
+    SCAN_KERNEL_VALUE(scan_between_##suffix, type, (m > lo) & (m < hi)) \
+    SCAN_KERNEL_PREVIOUS(scan_increased_##suffix, type, e, >) \
+    SCAN_KERNEL_PREVIOUS(scan_increased_by_##suffix, type, e + v, ==) \
+    SCAN_KERNEL_PREVIOUS(scan_decreased_##suffix, type, e, <) \
+    SCAN_KERNEL_PREVIOUS(scan_decreased_by_##suffix, type, e - v, ==) \
+    SCAN_KERNEL_PREVIOUS(scan_changed_##suffix, type, e, !=) \
+    SCAN_KERNEL_PREVIOUS(scan_unchanged_##suffix, type, e, ==)
+
+#define SCAN_KERNELS_SIMD(suffix, type, vtype, mask, scale) \
+    SCAN_KERNEL_PAIR_VALUE(scan_exact_##suffix, type, vtype, mask, scale, m == v) \
+    SCAN_KERNEL_PAIR_VALUE(scan_bigger_##suffix, type, vtype, mask, scale, m > v) \
+    SCAN_KERNEL_PAIR_VALUE(scan_less_##suffix, type, vtype, mask, scale, m < v) \
+    SCAN_KERNEL_PAIR_VALUE(scan_between_##suffix, type, vtype, mask, scale, (m > lo) & (m < hi)) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_increased_##suffix, type, vtype, mask, scale, e, >) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_increased_by_##suffix, type, vtype, mask, scale, e + v, ==) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_decreased_##suffix, type, vtype, mask, scale, e, <) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_decreased_by_##suffix, type, vtype, mask, scale, e - v, ==) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_changed_##suffix, type, vtype, mask, scale, e, !=) \
+    SCAN_KERNEL_PAIR_PREVIOUS(scan_unchanged_##suffix, type, vtype, mask, scale, e, ==)
+
+#define SCAN_FUZZY(type) ((v - m) < (type)1) & ((v - m) > (type)-1)
+
+#if defined(SCAN_SIMD_INTEGER)
+SCAN_KERNELS_SIMD(u8, uint8_t, v16u8, SCAN_MASK_8, 1)
+SCAN_KERNELS_SIMD(s8, int8_t, v16s8, SCAN_MASK_8, 1)
+SCAN_KERNELS_SIMD(u16, uint16_t, v8u16, SCAN_MASK_16, 1)
+SCAN_KERNELS_SIMD(s16, int16_t, v8s16, SCAN_MASK_16, 1)
+SCAN_KERNELS_SIMD(u32, uint32_t, v4u32, SCAN_MASK_32, 1)
+SCAN_KERNELS_SIMD(s32, int32_t, v4s32, SCAN_MASK_32, 1)
+SCAN_KERNELS_SIMD(u64, uint64_t, v2u64, SCAN_MASK_64, 1)
+SCAN_KERNELS_SIMD(s64, int64_t, v2s64, SCAN_MASK_64, 1)
+#define SCAN_KERNEL_INTEGER(name) name##_simd
+#else
+SCAN_KERNELS_SCALAR(u8, uint8_t)
+SCAN_KERNELS_SCALAR(s8, int8_t)
+SCAN_KERNELS_SCALAR(u16, uint16_t)
+SCAN_KERNELS_SCALAR(s16, int16_t)
+SCAN_KERNELS_SCALAR(u32, uint32_t)
+SCAN_KERNELS_SCALAR(s32, int32_t)
+SCAN_KERNELS_SCALAR(u64, uint64_t)
+SCAN_KERNELS_SCALAR(s64, int64_t)
+#define SCAN_KERNEL_INTEGER(name) name
+#endif
+
+#if defined(SCAN_SIMD_FLOAT)
+SCAN_KERNELS_SIMD(float, float, v8sf, SCAN_MASK_FLOAT, 4)
+SCAN_KERNELS_SIMD(double, double, v4df, SCAN_MASK_DOUBLE, 8)
+SCAN_KERNEL_PAIR_VALUE(scan_fuzzy_float, float, v8sf, SCAN_MASK_FLOAT, 4, SCAN_FUZZY(float))
+SCAN_KERNEL_PAIR_VALUE(scan_fuzzy_double, double, v4df, SCAN_MASK_DOUBLE, 8, SCAN_FUZZY(double))
+#define SCAN_KERNEL_FLOAT(name) name##_simd
+#else
+SCAN_KERNELS_SCALAR(float, float)
+SCAN_KERNELS_SCALAR(double, double)
+SCAN_KERNEL_VALUE(scan_fuzzy_float, float, SCAN_FUZZY(float))
+SCAN_KERNEL_VALUE(scan_fuzzy_double, double, SCAN_FUZZY(double))
+#define SCAN_KERNEL_FLOAT(name) name
+#endif
+
+// every aligned address is a candidate when the initial value is unknown
+static uint32_t scan_unknown(SCAN_KERNEL_ARGS) {
+    uint32_t count = 0;
+
+    if (length < valueLength)
+        return 0;
+
+    for (uint32_t off = 0; off <= length - valueLength; off += stride)
+        hits[count++] = off;
+
+    return count;
+}
+
+static uint32_t scan_exact_bytes(SCAN_KERNEL_ARGS) {
+    const uint8_t first = value[0];
+    uint32_t count = 0;
+
+    if (!valueLength || length < valueLength)
+        return 0;
+
+    for (uint32_t off = 0; off <= length - valueLength; off += stride) {
+        if (memory[off] == first && !memcmp(memory + off, value, valueLength))
+            hits[count++] = off;
+    }
+
+    return count;
+}
+
+#define SCAN_KERNEL_ROW(suffix, K) { \
+    [SCAN_CMP_EXACT]           = K(scan_exact_##suffix), \
+    [SCAN_CMP_BIGGER_THAN]     = K(scan_bigger_##suffix), \
+    [SCAN_CMP_LESS_THAN]       = K(scan_less_##suffix), \
+    [SCAN_CMP_BETWEEN]         = K(scan_between_##suffix), \
+    [SCAN_CMP_INCREASED]       = K(scan_increased_##suffix), \
+    [SCAN_CMP_INCREASED_BY]    = K(scan_increased_by_##suffix), \
+    [SCAN_CMP_DECREASED]       = K(scan_decreased_##suffix), \
+    [SCAN_CMP_DECREASED_BY]    = K(scan_decreased_by_##suffix), \
+    [SCAN_CMP_CHANGED]         = K(scan_changed_##suffix), \
+    [SCAN_CMP_UNCHANGED]       = K(scan_unchanged_##suffix), \
+    [SCAN_CMP_UNKNOWN_INITIAL] = scan_unknown, \
+}
+
+// fuzzy compares only make sense for floating point values
+#define SCAN_KERNEL_ROW_FLOAT(suffix) { \
+    [SCAN_CMP_EXACT]           = SCAN_KERNEL_FLOAT(scan_exact_##suffix), \
+    [SCAN_CMP_FUZZY]           = SCAN_KERNEL_FLOAT(scan_fuzzy_##suffix), \
+    [SCAN_CMP_BIGGER_THAN]     = SCAN_KERNEL_FLOAT(scan_bigger_##suffix), \
+    [SCAN_CMP_LESS_THAN]       = SCAN_KERNEL_FLOAT(scan_less_##suffix), \
+    [SCAN_CMP_BETWEEN]         = SCAN_KERNEL_FLOAT(scan_between_##suffix), \
+    [SCAN_CMP_INCREASED]       = SCAN_KERNEL_FLOAT(scan_increased_##suffix), \
+    [SCAN_CMP_INCREASED_BY]    = SCAN_KERNEL_FLOAT(scan_increased_by_##suffix), \
+    [SCAN_CMP_DECREASED]       = SCAN_KERNEL_FLOAT(scan_decreased_##suffix), \
+    [SCAN_CMP_DECREASED_BY]    = SCAN_KERNEL_FLOAT(scan_decreased_by_##suffix), \
+    [SCAN_CMP_CHANGED]         = SCAN_KERNEL_FLOAT(scan_changed_##suffix), \
+    [SCAN_CMP_UNCHANGED]       = SCAN_KERNEL_FLOAT(scan_unchanged_##suffix), \
+    [SCAN_CMP_UNKNOWN_INITIAL] = scan_unknown, \
+}
+
+static const scan_kernel_t scan_kernels[SCAN_VAL_MAX][SCAN_CMP_MAX] = {
+    [SCAN_VAL_U8]     = SCAN_KERNEL_ROW(u8, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_S8]     = SCAN_KERNEL_ROW(s8, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_U16]    = SCAN_KERNEL_ROW(u16, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_S16]    = SCAN_KERNEL_ROW(s16, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_U32]    = SCAN_KERNEL_ROW(u32, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_S32]    = SCAN_KERNEL_ROW(s32, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_U64]    = SCAN_KERNEL_ROW(u64, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_S64]    = SCAN_KERNEL_ROW(s64, SCAN_KERNEL_INTEGER),
+    [SCAN_VAL_FLOAT]  = SCAN_KERNEL_ROW_FLOAT(float),
+    [SCAN_VAL_DOUBLE] = SCAN_KERNEL_ROW_FLOAT(double),
+    [SCAN_VAL_BYTE_ARRAY] = {
+        [SCAN_CMP_EXACT]           = scan_exact_bytes,
+        [SCAN_CMP_UNKNOWN_INITIAL] = scan_unknown,
+    },
+    [SCAN_VAL_STRING] = {
+        [SCAN_CMP_EXACT]           = scan_exact_bytes,
+        [SCAN_CMP_UNKNOWN_INITIAL] = scan_unknown,
+    },
+};
+
+scan_kernel_t scan_get_kernel(cmd_proc_scan_valuetype valType, cmd_proc_scan_comparetype cmpType) {
+    if (valType >= SCAN_VAL_MAX || cmpType >= SCAN_CMP_MAX)
+        return NULL;
+
+    return scan_kernels[valType][cmpType];
+}
+
+void scan_use_system(struct scan_params *params, cmd_proc_scan_valuetype valType, cmd_proc_scan_comparetype cmpType, uint8_t flags) {
+    params->valueType = valType;
+    params->compareType = cmpType;
+
+    // the kdebugger only knows the integers and the compares against the scan
+    // value, floats would need the fpu saved in the kernel
+    params->system = (flags & SCAN_FLAG_SYSTEM) && valType <= SCAN_VAL_S64 &&
+                     (cmpType == SCAN_CMP_EXACT || cmpType == SCAN_CMP_BIGGER_THAN ||
+                      cmpType == SCAN_CMP_LESS_THAN || cmpType == SCAN_CMP_BETWEEN);
+}
+
+uint64_t scan_filter_maps(const struct cmd_proc_scan_filter *filter, uint32_t stride, struct proc_vm_map_entry *maps, uint64_t num) {
+    char name[sizeof(filter->name) + 1];
+    char entry[sizeof(maps->name) + 1];
+    uint64_t end = filter->end ? filter->end : (uint64_t)-1;
+    uint64_t kept = 0;
+
+    // neither name has to be terminated
+    memcpy(name, filter->name, sizeof(filter->name));
+    name[sizeof(filter->name)] = 0;
+    entry[sizeof(maps->name)] = 0;
+
+    for (uint64_t i = 0; i < num; i++) {
+        struct proc_vm_map_entry map = maps[i];
+
+        if ((map.prot & filter->protSet) != filter->protSet || (map.prot & filter->protClear)) {
+            continue;
+        }
+
+        if (filter->nameMode != SCAN_NAME_ANY) {
+            int match;
+
+            memcpy(entry, map.name, sizeof(map.name));
+            match = name[0] ? strstr(entry, name) != NULL : !entry[0];
+            if (match != (filter->nameMode == SCAN_NAME_INCLUDE)) {
+                continue;
+            }
+        }
+
+        if (map.end <= filter->start || map.start >= end) {
+            continue;
+        }
+
+        if (map.start < filter->start) {
+            map.start += ((filter->start - map.start + stride - 1) / stride) * stride;
+        }
+
+        if (map.end > end) {
+            map.end = end;
+        }
+
+        if (map.start < map.end) {
+            maps[kept++] = map;
+        }
+    }
+
+    return kept;
+}
+
+// compare types that look at the previous value instead of the scan value
+int scan_is_relative(cmd_proc_scan_comparetype cmpType) {
+    switch (cmpType) {
+        case SCAN_CMP_INCREASED:
+        case SCAN_CMP_INCREASED_BY:
+        case SCAN_CMP_DECREASED:
+        case SCAN_CMP_DECREASED_BY:
+        case SCAN_CMP_CHANGED:
+        case SCAN_CMP_UNCHANGED:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Regions are cut into items of one chunk each that the workers pick up
+// in order from a shared counter, whoever is free takes the next one. Every
+// item has a slot (item % numSlots) holding its buffer and hits until the
+// calling thread merged it into the sink, so the sink still sees the results
+// in address order and never gets called from more than one thread.
+// Items also read the valueLength - 1 bytes after them (as far as the region
+// goes) so values that straddle two chunks are still found, hits starting in
+// that overlap are left to the next item.
+struct scan_item {
+    uint64_t start;
+    uint32_t length;
+    uint32_t readLength;
+    uint32_t entry;         // index into maps, for the region callback
+};
+
+struct scan_slot {
+    volatile uint64_t done; // item + 1 once the results are in
+    int error;              // the hits did not fit, the results are incomplete
+    uint8_t *buffer;
+    uint32_t *hits;
+    uint32_t count;
+    uint32_t capacity;
+};
+
+struct scan_pool {
+    struct scan_params *params;
+    uint32_t chunk;
+    struct scan_item *items;
+    uint64_t numItems;
+    struct scan_slot *slots;
+    uint32_t numSlots;
+    volatile uint64_t next;     // next item to scan
+    volatile uint64_t merged;   // items handed to the sink so far
+    volatile int stop;
+};
+
+static uint32_t scan_get_workers() {
+    int mib[2];
+    size_t len;
+    int ncpu = 0;
+
+    len = sizeof(ncpu);
+    mib[0] = 6; // CTL_HW
+    mib[1] = 3; // HW_NCPU
+    syscall(202, mib, 2, &ncpu, &len, NULL, 0);
+
+    // leave a core to the game and the other client threads
+    if (ncpu > SCAN_MAX_WORKERS + 1) {
+        return SCAN_MAX_WORKERS;
+    }
+
+    return ncpu > 1 ? ncpu - 1 : 1;
+}
+
+// keeps the offsets below limit, hits are always ascending
+static inline uint32_t scan_trim(const uint32_t *hits, uint32_t count, uint32_t limit) {
+    while (count && hits[count - 1] >= limit) {
+        count--;
+    }
+
+    return count;
+}
+
+// lets the kdebugger compare the item against the target pages, only the hits
+// and their values are written back, returns non zero when the item has to be
+// scanned here (the kernel failed to read it or ran out of room for the hits)
+static int scan_pool_system(struct scan_pool *pool, struct scan_item *item, struct scan_slot *slot) {
+    struct scan_params *params = pool->params;
+    struct sys_proc_scan_args args;
+
+    memset(&args, NULL, sizeof(args));
+    args.address = item->start;
+    args.length = item->readLength;
+    args.limit = item->length;
+    args.valueType = params->valueType;
+    args.compareType = params->compareType;
+    memcpy(args.value, params->value, params->valueLength);
+    memcpy(args.extra, params->extra ? params->extra : params->value, params->valueLength);
+    args.stride = params->stride;
+    args.data = slot->buffer;
+    args.hits = slot->hits;
+    args.maxHits = slot->capacity;
+
+    if (sys_proc_cmd(params->pid, SYS_PROC_SCAN, &args)) {
+        return 1;
+    }
+
+    slot->count = args.count;
+
+    return 0;
+}
+
+static void scan_pool_run(struct scan_pool *pool, uint64_t i) {
+    struct scan_params *params = pool->params;
+    struct scan_item *item = &pool->items[i];
+    struct scan_slot *slot = &pool->slots[i % pool->numSlots];
+    uint32_t room = SCAN_MAX_HITS(SCAN_PIECE_SIZE + params->valueLength, params->stride);
+
+    slot->error = 0;
+    if (params->system && !scan_pool_system(pool, item, slot)) {
+        __sync_synchronize();
+        slot->done = i + 1;
+        return;
+    }
+
+    // one read for the whole chunk, then compare it piece by piece so the
+    // hits only need as much room as there were matches, the buffer still
+    // holds an older item when the read fails so nothing is compared then
+    slot->count = 0;
+    if (sys_proc_rw(params->pid, item->start, slot->buffer, item->readLength, 0)) {
+        __sync_synchronize();
+        slot->done = i + 1;
+        return;
+    }
+
+    // pieces stay a multiple of the stride as well, the kernels count the
+    // stride from the start of what they are given
+    uint32_t size = SCAN_PIECE_SIZE - SCAN_PIECE_SIZE % params->stride;
+    if (!size) {
+        size = params->stride;
+    }
+
+    for (uint32_t pos = 0; pos < item->length; pos += size) {
+        uint32_t piece = item->length - pos > size ? size : item->length - pos;
+        uint32_t length = piece + params->valueLength - 1;
+        if (length > item->readLength - pos) {
+            length = item->readLength - pos;
+        }
+
+        if (slot->count + room > slot->capacity) {
+            uint32_t capacity = slot->capacity * 2;
+            while (capacity < slot->count + room) {
+                capacity *= 2;
+            }
+
+            // a partial list would look like a complete scan, so the whole
+            // scan stops instead
+            uint32_t *hits = (uint32_t *)realloc(slot->hits, capacity * sizeof(uint32_t));
+            if (!hits) {
+                slot->error = 1;
+                pool->stop = 1;
+                break;
+            }
+
+            // the kernel writes the hits straight into this
+            if (params->system) {
+                prefault(hits + slot->capacity, (capacity - slot->capacity) * sizeof(uint32_t));
+            }
+
+            slot->hits = hits;
+            slot->capacity = capacity;
+        }
+
+        uint32_t *hits = slot->hits + slot->count;
+        uint32_t count = params->kernel(slot->buffer + pos, length, params->stride, params->value, params->extra, 0, params->valueLength, hits);
+        count = scan_trim(hits, count, piece);
+
+        for (uint32_t k = 0; k < count; k++) {
+            hits[k] += pos;
+        }
+
+        slot->count += count;
+    }
+
+    __sync_synchronize();
+    slot->done = i + 1;
+}
+
+// scans the next item if its slot is free, returns 0 when there was nothing to do
+static int scan_pool_help(struct scan_pool *pool) {
+    uint64_t i = pool->next;
+
+    if (pool->stop || i >= pool->numItems || i >= pool->merged + pool->numSlots) {
+        return 0;
+    }
+
+    if (!__sync_bool_compare_and_swap(&pool->next, i, i + 1)) {
+        return 1;
+    }
+
+    scan_pool_run(pool, i);
+
+    return 1;
+}
+
+static void *scan_worker(void *arg) {
+    struct scan_pool *pool = (struct scan_pool *)arg;
+
+    while (!pool->stop) {
+        uint64_t i = __sync_fetch_and_add(&pool->next, 1);
+        if (i >= pool->numItems) {
+            break;
+        }
+
+        // the slot is still holding an item that was not merged yet
+        while (i >= pool->merged + pool->numSlots && !pool->stop) {
+            scePthreadYield();
+        }
+
+        if (pool->stop) {
+            break;
+        }
+
+        scan_pool_run(pool, i);
+    }
+
+    return NULL;
+}
+
+static int scan_pool_init(struct scan_pool *pool, struct scan_params *params, struct proc_vm_map_entry *maps, uint64_t num, uint32_t workers) {
+    uint64_t n = 0;
+
+    memset(pool, NULL, sizeof(struct scan_pool));
+    pool->params = params;
+
+    // chunks stay a multiple of the stride so every item starts on a value
+    pool->chunk = params->chunkSize ? params->chunkSize : SCAN_CHUNK_SIZE;
+    if (pool->chunk < SCAN_MIN_CHUNK_SIZE) {
+        pool->chunk = SCAN_MIN_CHUNK_SIZE;
+    } else if (pool->chunk > SCAN_MAX_CHUNK_SIZE) {
+        pool->chunk = SCAN_MAX_CHUNK_SIZE;
+    }
+
+    pool->chunk -= pool->chunk % params->stride;
+    if (!pool->chunk) {
+        pool->chunk = params->stride;
+    }
+
+    for (uint64_t i = 0; i < num; i++) {
+        if ((maps[i].prot & PROT_READ) == PROT_READ) {
+            pool->numItems += (maps[i].end - maps[i].start + pool->chunk - 1) / pool->chunk;
+        }
+    }
+
+    if (!pool->numItems) {
+        return 0;
+    }
+
+    pool->items = (struct scan_item *)malloc(pool->numItems * sizeof(struct scan_item));
+    if (!pool->items) {
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < num; i++) {
+        if ((maps[i].prot & PROT_READ) != PROT_READ) {
+            continue;
+        }
+
+        for (uint64_t start = maps[i].start; start < maps[i].end; start += pool->chunk) {
+            uint64_t left = maps[i].end - start;
+
+            pool->items[n].start = start;
+            pool->items[n].length = left > pool->chunk ? pool->chunk : left;
+            pool->items[n].readLength = left > pool->chunk + params->valueLength - 1 ? pool->chunk + params->valueLength - 1 : left;
+            pool->items[n].entry = i;
+            n++;
+        }
+    }
+
+    pool->numSlots = workers * SCAN_SLOTS_PER_WORKER;
+    pool->slots = (struct scan_slot *)malloc(pool->numSlots * sizeof(struct scan_slot));
+    if (!pool->slots) {
+        return 1;
+    }
+
+    memset(pool->slots, NULL, pool->numSlots * sizeof(struct scan_slot));
+
+    for (uint32_t i = 0; i < pool->numSlots; i++) {
+        pool->slots[i].buffer = (uint8_t *)pfmalloc(pool->chunk + params->valueLength - 1);
+        pool->slots[i].capacity = SCAN_MAX_HITS(SCAN_PIECE_SIZE + params->valueLength, params->stride);
+        pool->slots[i].hits = (uint32_t *)pfmalloc(pool->slots[i].capacity * sizeof(uint32_t));
+        if (!pool->slots[i].buffer || !pool->slots[i].hits) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void scan_pool_free(struct scan_pool *pool) {
+    if (pool->slots) {
+        for (uint32_t i = 0; i < pool->numSlots; i++) {
+            if (pool->slots[i].buffer) {
+                free(pool->slots[i].buffer);
+            }
+
+            if (pool->slots[i].hits) {
+                free(pool->slots[i].hits);
+            }
+        }
+
+        free(pool->slots);
+    }
+
+    if (pool->items) {
+        free(pool->items);
+    }
+}
+
+int scan_regions(struct scan_params *params, struct proc_vm_map_entry *maps, uint64_t num, struct scan_sink *sink) {
+    ScePthread threads[SCAN_MAX_WORKERS];
+    struct scan_pool pool;
+    uint32_t workers;
+    uint32_t started = 0;
+    int r = 0;
+
+    if (!params->kernel || !params->stride) {
+        return 1;
+    }
+
+    workers = scan_get_workers();
+
+    if (scan_pool_init(&pool, params, maps, num, workers)) {
+        r = 1;
+        goto finish;
+    }
+
+    // a single item does not need any help
+    for (uint32_t i = 0; i < workers && pool.numItems > 1; i++) {
+        if (scePthreadCreate(&threads[started], NULL, scan_worker, &pool, "scanworker")) {
+            break;
+        }
+
+        started++;
+    }
+
+    for (uint64_t i = 0; i < pool.numItems && !r; i++) {
+        struct scan_item *item = &pool.items[i];
+        struct scan_slot *slot = &pool.slots[i % pool.numSlots];
+
+        // scan something ourselves while waiting, this also covers the case
+        // where no worker could be started
+        while (slot->done != i + 1 && !pool.stop) {
+            if (!scan_pool_help(&pool)) {
+                scePthreadYield();
+            }
+        }
+
+        __sync_synchronize();
+
+        // a worker ran out of memory, the items after it are not scanned
+        if (slot->done != i + 1 || slot->error) {
+            r = 1;
+            break;
+        }
+
+        if (item->start == maps[item->entry].start && sink->region) {
+            r = sink->region(sink->arg, &maps[item->entry]);
+        }
+
+        if (!r && slot->count && sink->hits) {
+            r = sink->hits(sink->arg, item->start, slot->buffer, item->readLength, slot->hits, slot->count);
+        }
+
+        if (!r && sink->progress) {
+            r = sink->progress(sink->arg, item->length);
+        }
+
+        __sync_synchronize();
+        pool.merged = i + 1;
+    }
+
+    pool.stop = 1;
+
+    for (uint32_t i = 0; i < started; i++) {
+        scePthreadJoin(threads[i], NULL);
+    }
+
+finish:
+    scan_pool_free(&pool);
+
+    return r;
+}
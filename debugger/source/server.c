@@ -15,6 +15,10 @@ struct server_client *alloc_client() {
 void free_client(struct server_client *svc) {
     uprintf("Freeing Server Clients...");
     svc->id = 0;
+    session_free(svc->fd);
+    pointer_free(svc->fd);
+    transfer_free(svc->fd);
+    watch_free(svc->fd);
     sceNetSocketClose(svc->fd);
 
     if (svc->debugging) 
@@ -0,0 +1,791 @@
+#include "../include/session.h"
+#include "../include/proc.h"
+#include "../include/lz4.h"
+
+static struct scan_session sessions[SESSION_MAX];
+
+static inline void session_copy(uint8_t *dst, const uint8_t *src, uint32_t length) {
+    switch (length) {
+        case 1: *dst = *src; break;
+        case 2: *(uint16_t *)dst = *(const uint16_t *)src; break;
+        case 4: *(uint32_t *)dst = *(const uint32_t *)src; break;
+        case 8: *(uint64_t *)dst = *(const uint64_t *)src; break;
+        default: memcpy(dst, src, length); break;
+    }
+}
+
+// bitmaps are rounded up to whole qwords so they can be walked 64 slots at a time
+static inline uint64_t session_bitmap_size(uint64_t slots) {
+    return ((slots + 63) / 64) * sizeof(uint64_t);
+}
+
+static void session_set_free(struct session_set *set) {
+    if (set->data) {
+        free(set->data);
+    }
+
+    memset(set, NULL, sizeof(struct session_set));
+}
+
+static int session_set_to_bitmap(struct session_set *set, uint64_t slots) {
+    struct session_cursor cursor;
+    uint64_t size = session_bitmap_size(slots);
+    uint64_t slot;
+    uint8_t *bitmap;
+
+    bitmap = (uint8_t *)malloc(size);
+    if (!bitmap) {
+        return 1;
+    }
+
+    memset(bitmap, NULL, size);
+
+    memset(&cursor, NULL, sizeof(cursor));
+    while (session_set_next(set, &cursor, &slot)) {
+        bitmap[slot >> 3] |= 1 << (slot & 7);
+    }
+
+    free(set->data);
+    set->encoding = SESSION_SET_BITMAP;
+    set->data = bitmap;
+    set->length = size;
+    set->capacity = size;
+
+    return 0;
+}
+
+// slots have to be added in ascending order
+static int session_set_add(struct session_set *set, uint64_t slots, uint64_t slot) {
+    uint64_t delta;
+
+    if (set->encoding == SESSION_SET_BITMAP) {
+        set->data[slot >> 3] |= 1 << (slot & 7);
+        set->count++;
+        return 0;
+    }
+
+    // a LEB128 value of 64 bits takes at most 10 bytes
+    if (set->length + 10 > set->capacity) {
+        uint64_t capacity = set->capacity ? set->capacity * 2 : 256;
+        uint8_t *data = (uint8_t *)realloc(set->data, capacity);
+        if (!data) {
+            return 1;
+        }
+
+        set->data = data;
+        set->capacity = capacity;
+    }
+
+    delta = slot - set->last;
+    while (delta >= 0x80) {
+        set->data[set->length++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    set->data[set->length++] = (uint8_t)delta;
+
+    set->last = slot;
+    set->count++;
+
+    // dense sets are smaller as a bitmap
+    if (set->length > session_bitmap_size(slots)) {
+        return session_set_to_bitmap(set, slots);
+    }
+
+    return 0;
+}
+
+int session_set_next(struct session_set *set, struct session_cursor *cursor, uint64_t *slot) {
+    if (cursor->index >= set->count) {
+        return 0;
+    }
+
+    if (set->encoding == SESSION_SET_BITMAP) {
+        uint64_t *words = (uint64_t *)set->data;
+        uint64_t bit = cursor->offset;
+        uint64_t word = words[bit >> 6] >> (bit & 63);
+
+        // count says there is another bit, so this ends
+        while (!word) {
+            bit = (bit | 63) + 1;
+            word = words[bit >> 6];
+        }
+
+        bit += __builtin_ctzll(word);
+        cursor->slot = bit;
+        cursor->offset = bit + 1;
+    } else {
+        uint64_t delta = 0;
+        uint32_t shift = 0;
+        uint8_t byte;
+
+        do {
+            byte = set->data[cursor->offset++];
+            delta |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        cursor->slot += delta;
+    }
+
+    cursor->index++;
+    *slot = cursor->slot;
+
+    return 1;
+}
+
+uint64_t session_region_count(struct session_region *region) {
+    return region->pages ? region->slots : region->set.count;
+}
+
+static void session_pages_free(struct session_region *region) {
+    if (!region->pages) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < region->numPages; i++) {
+        if (region->pages[i].data) {
+            free(region->pages[i].data);
+        }
+    }
+
+    free(region->pages);
+    region->pages = NULL;
+    region->numPages = 0;
+}
+
+// expands a snapshot page into buffer, raw pages are used as they are,
+// returns NULL when a compressed page does not decode
+static const uint8_t *session_page_data(struct session_page *page, uint8_t *buffer) {
+    if (page->type == SESSION_PAGE_RAW) {
+        return page->data;
+    }
+
+    if (page->type == SESSION_PAGE_LZ4) {
+        return lz4_decompress(page->data, page->length, buffer, PAGE_SIZE) ? NULL : buffer;
+    }
+
+    for (uint32_t i = 0; i < PAGE_SIZE; i += sizeof(uint64_t)) {
+        *(uint64_t *)(buffer + i) = page->fill;
+    }
+
+    return buffer;
+}
+
+// scratch is SESSION_LZ4_LIMIT bytes and table LZ4_TABLE_SIZE bytes
+static int session_page_store(struct session_page *page, const uint8_t *memory, uint8_t *scratch, uint32_t *table) {
+    const uint64_t *words = (const uint64_t *)memory;
+    const uint8_t *data = memory;
+    uint32_t i = 1;
+
+    while (i < PAGE_SIZE / sizeof(uint64_t) && words[i] == words[0]) {
+        i++;
+    }
+
+    page->fill = words[0];
+    page->data = NULL;
+    page->length = 0;
+
+    if (i == PAGE_SIZE / sizeof(uint64_t)) {
+        page->type = words[0] ? SESSION_PAGE_FILL : SESSION_PAGE_ZERO;
+        return 0;
+    }
+
+    page->type = SESSION_PAGE_LZ4;
+    page->length = lz4_compress(memory, PAGE_SIZE, scratch, SESSION_LZ4_LIMIT, table);
+    if (page->length) {
+        data = scratch;
+    } else {
+        page->type = SESSION_PAGE_RAW;
+        page->length = PAGE_SIZE;
+    }
+
+    page->data = (uint8_t *)malloc(page->length);
+    if (!page->data) {
+        return 1;
+    }
+
+    memcpy(page->data, data, page->length);
+
+    return 0;
+}
+
+static void session_clear(struct scan_session *session) {
+    for (uint64_t i = 0; i < session->numRegions; i++) {
+        session_set_free(&session->regions[i].set);
+        session_pages_free(&session->regions[i]);
+
+        if (session->regions[i].values) {
+            free(session->regions[i].values);
+        }
+    }
+
+    if (session->regions) {
+        free(session->regions);
+    }
+
+    session->regions = NULL;
+    session->numRegions = 0;
+    session->capRegions = 0;
+    session->count = 0;
+    session->resultsValid = 0;
+    session->resultsPage = NULL;
+}
+
+struct scan_session *session_find(int fd) {
+    for (int i = 0; i < SESSION_MAX; i++) {
+        if (sessions[i].fd == fd) {
+            return &sessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+struct scan_session *session_create(int fd, uint32_t pid, uint8_t valueType, uint32_t valueLength) {
+    struct scan_session *session;
+
+    // a client only has one session, opening a new one replaces it
+    session = session_find(fd);
+    if (session) {
+        session_clear(session);
+    } else {
+        for (int i = 0; i < SESSION_MAX && !session; i++) {
+            if (__sync_bool_compare_and_swap(&sessions[i].fd, 0, fd)) {
+                session = &sessions[i];
+            }
+        }
+
+        if (!session) {
+            return NULL;
+        }
+    }
+
+    session->pid = pid;
+    session->valueType = valueType;
+    session->valueLength = valueLength;
+    session->stride = valueLength;
+    session->chunkSize = 0;
+    session->flags = 0;
+    memset(&session->filter, NULL, sizeof(session->filter));
+
+    return session;
+}
+
+void session_free(int fd) {
+    struct scan_session *session = session_find(fd);
+    if (!session) {
+        return;
+    }
+
+    session_clear(session);
+
+    if (session->resultsData) {
+        free(session->resultsData);
+    }
+
+    memset(session, NULL, sizeof(struct scan_session));
+}
+
+static int session_region_handler(void *arg, struct proc_vm_map_entry *entry) {
+    struct scan_session *session = (struct scan_session *)arg;
+    struct session_region *regions;
+    struct session_region *region;
+
+    // reuse the last region if nothing matched in it
+    if (session->numRegions && !session_region_count(&session->regions[session->numRegions - 1])) {
+        region = &session->regions[session->numRegions - 1];
+        session_set_free(&region->set);
+    } else {
+        if (session->numRegions == session->capRegions) {
+            uint64_t capacity = session->capRegions ? session->capRegions * 2 : 64;
+            regions = (struct session_region *)realloc(session->regions, capacity * sizeof(struct session_region));
+            if (!regions) {
+                return 1;
+            }
+
+            session->regions = regions;
+            session->capRegions = capacity;
+        }
+
+        region = &session->regions[session->numRegions++];
+        memset(region, NULL, sizeof(struct session_region));
+    }
+
+    region->start = entry->start;
+    region->end = entry->end;
+    region->slots = (entry->end - entry->start) / session->stride;
+
+    return 0;
+}
+
+static int session_values_reserve(struct session_region *region, uint64_t count, uint32_t length) {
+    if (count <= region->capacity) {
+        return 0;
+    }
+
+    uint64_t capacity = region->capacity ? region->capacity * 2 : 1024;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    uint8_t *values = (uint8_t *)realloc(region->values, capacity * length);
+    if (!values) {
+        return 1;
+    }
+
+    region->values = values;
+    region->capacity = capacity;
+
+    return 0;
+}
+
+static int session_hits_handler(void *arg, uint64_t address, const uint8_t *buffer, uint32_t size, const uint32_t *hits, uint32_t count) {
+    struct scan_session *session = (struct scan_session *)arg;
+    struct session_region *region = &session->regions[session->numRegions - 1];
+    uint32_t length = session->valueLength;
+    uint64_t first = (address - region->start) / session->stride;
+
+    if (session_values_reserve(region, region->set.count + count, length)) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        session_copy(region->values + region->set.count * length, buffer + hits[i], length);
+        if (session_set_add(&region->set, region->slots, first + hits[i] / session->stride)) {
+            return 1;
+        }
+    }
+
+    session->count += count;
+
+    return 0;
+}
+
+// drop the regions that have no candidates left
+static void session_compact(struct scan_session *session) {
+    uint64_t kept = 0;
+
+    for (uint64_t i = 0; i < session->numRegions; i++) {
+        struct session_region *region = &session->regions[i];
+
+        if (!session_region_count(region)) {
+            session_set_free(&region->set);
+            session_pages_free(region);
+
+            if (region->values) {
+                free(region->values);
+            }
+
+            continue;
+        }
+
+        session->regions[kept++] = *region;
+    }
+
+    session->numRegions = kept;
+    session->resultsValid = 0;
+    session->resultsPage = NULL;
+}
+
+// snapshots are compared page by page, so values must not cross pages and the
+// fill pattern must hold whole values
+// the snapshot keeps whole pages, a window that cuts into one leaves it out
+static int session_can_snapshot(struct scan_session *session) {
+    return session->valueLength <= sizeof(uint64_t) && session->stride <= sizeof(uint64_t) &&
+           !(sizeof(uint64_t) % session->stride) && session->stride >= session->valueLength &&
+           !(session->filter.start % PAGE_SIZE) && !(session->filter.end % PAGE_SIZE);
+}
+
+static int session_snapshot(struct scan_session *session, struct proc_vm_map_entry *maps, uint64_t num) {
+    uint8_t *buffer;
+    uint8_t *scratch;
+    uint32_t *table;
+    int r = 0;
+
+    buffer = (uint8_t *)pfmalloc(SESSION_READ_SPAN);
+    scratch = (uint8_t *)pfmalloc(SESSION_LZ4_LIMIT);
+    table = (uint32_t *)pfmalloc(LZ4_TABLE_SIZE);
+    if (!buffer || !scratch || !table) {
+        r = 1;
+        goto finish;
+    }
+
+    for (uint64_t i = 0; i < num && !r; i++) {
+        struct session_region *region;
+
+        if ((maps[i].prot & PROT_READ) != PROT_READ) {
+            continue;
+        }
+
+        if ((r = session_region_handler(session, &maps[i]))) {
+            break;
+        }
+
+        region = &session->regions[session->numRegions - 1];
+        region->numPages = (region->end - region->start) / PAGE_SIZE;
+        region->pages = (struct session_page *)calloc(region->numPages, sizeof(struct session_page));
+        if (!region->pages) {
+            r = 1;
+            break;
+        }
+
+        for (uint64_t j = 0; j < region->numPages && !r; j += SESSION_READ_SPAN / PAGE_SIZE) {
+            uint64_t pages = region->numPages - j > SESSION_READ_SPAN / PAGE_SIZE ? SESSION_READ_SPAN / PAGE_SIZE : region->numPages - j;
+
+            // every slot of a snapshot is a candidate, a region that can not
+            // be read as a whole is left out instead
+            if (sys_proc_rw(session->pid, region->start + j * PAGE_SIZE, buffer, pages * PAGE_SIZE, 0)) {
+                session_pages_free(region);
+                region->slots = 0;
+                break;
+            }
+
+            for (uint64_t k = 0; k < pages && !r; k++) {
+                r = session_page_store(&region->pages[j + k], buffer + k * PAGE_SIZE, scratch, table);
+            }
+        }
+
+        session->count += session_region_count(region);
+    }
+
+finish:
+    if (table) {
+        free(table);
+    }
+
+    if (scratch) {
+        free(scratch);
+    }
+
+    if (buffer) {
+        free(buffer);
+    }
+
+    return r;
+}
+
+int session_scan(struct scan_session *session, uint8_t compareType, uint8_t *value, uint8_t *extra) {
+    struct proc_vm_map_entry *maps;
+    struct scan_params params;
+    struct scan_sink sink;
+    uint64_t num;
+    int r;
+
+    if (proc_get_vm_map(session->pid, &maps, &num)) {
+        return 1;
+    }
+
+    num = scan_filter_maps(&session->filter, session->stride, maps, num);
+
+    if (compareType == SCAN_CMP_UNKNOWN_INITIAL && session_can_snapshot(session)) {
+        r = session_snapshot(session, maps, num);
+
+        session_compact(session);
+
+        free(maps);
+
+        return r;
+    }
+
+    params.pid = session->pid;
+    params.kernel = scan_get_kernel(session->valueType, compareType);
+    params.value = value;
+    params.extra = extra;
+    params.valueLength = session->valueLength;
+    params.stride = session->stride;
+    params.chunkSize = session->chunkSize;
+    scan_use_system(&params, session->valueType, compareType, session->flags);
+
+    sink.region = session_region_handler;
+    sink.hits = session_hits_handler;
+    sink.progress = NULL;
+    sink.arg = session;
+
+    r = scan_regions(&params, maps, num, &sink);
+
+    session_compact(session);
+
+    free(maps);
+
+    return r;
+}
+
+// compares a snapshot region against the process a span at a time, the
+// survivors become the candidate set of the region and the snapshot goes away
+static int session_refine_snapshot(struct scan_session *session, struct session_region *region, scan_kernel_t kernel,
+                                   uint8_t *value, uint8_t *extra, int relative, uint8_t *span, uint32_t *hits) {
+    uint32_t length = session->valueLength;
+    uint32_t stride = session->stride;
+    uint8_t *fill;
+    int r = 0;
+
+    fill = (uint8_t *)pfmalloc(PAGE_SIZE);
+    if (!fill) {
+        return 1;
+    }
+
+    for (uint64_t j = 0; j < region->numPages && !r; j += SESSION_READ_SPAN / PAGE_SIZE) {
+        uint64_t pages = region->numPages - j > SESSION_READ_SPAN / PAGE_SIZE ? SESSION_READ_SPAN / PAGE_SIZE : region->numPages - j;
+
+        // nothing in the span survives when it can not be read anymore
+        if (sys_proc_rw(session->pid, region->start + j * PAGE_SIZE, span, pages * PAGE_SIZE, 0)) {
+            continue;
+        }
+
+        for (uint64_t k = 0; k < pages && !r; k++) {
+            const uint8_t *current = span + k * PAGE_SIZE;
+            const uint8_t *previous = session_page_data(&region->pages[j + k], fill);
+            uint64_t first = (j + k) * PAGE_SIZE / stride;
+
+            if (!previous) {
+                r = 1;
+                break;
+            }
+
+            uint32_t count = kernel(current, PAGE_SIZE, stride, value, relative ? previous : extra, relative ? stride : 0, length, hits);
+
+            if (session_values_reserve(region, region->set.count + count, length)) {
+                r = 1;
+                break;
+            }
+
+            for (uint32_t n = 0; n < count; n++) {
+                session_copy(region->values + region->set.count * length, current + hits[n], length);
+                if (session_set_add(&region->set, region->slots, first + hits[n] / stride)) {
+                    r = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    session_pages_free(region);
+
+    free(fill);
+
+    return r;
+}
+
+int session_refine(struct scan_session *session, uint8_t compareType, uint8_t *value, uint8_t *extra) {
+    uint32_t length = session->valueLength;
+    uint32_t stride = session->stride;
+    scan_kernel_t kernel;
+    uint8_t *span;
+    uint8_t *current;
+    uint64_t *slots;
+    uint32_t *hits;
+    int relative;
+    int r = 0;
+
+    kernel = scan_get_kernel(session->valueType, compareType);
+    if (!kernel) {
+        return 1;
+    }
+
+    // only the plain relative compares go without a value, the _BY ones take
+    // the distance from it
+    relative = scan_is_relative(compareType);
+    if (!value && compareType != SCAN_CMP_UNKNOWN_INITIAL &&
+        (!relative || compareType == SCAN_CMP_INCREASED_BY || compareType == SCAN_CMP_DECREASED_BY)) {
+        return 1;
+    }
+
+    span = (uint8_t *)pfmalloc(SESSION_READ_SPAN);
+    current = (uint8_t *)pfmalloc(SESSION_BATCH * length);
+    slots = (uint64_t *)pfmalloc(SESSION_BATCH * sizeof(uint64_t));
+    // room for a batch of candidates or a whole snapshot page
+    hits = (uint32_t *)pfmalloc(SCAN_MAX_HITS(SESSION_BATCH * length + PAGE_SIZE, stride < length ? stride : length) * sizeof(uint32_t));
+    if (!span || !current || !slots || !hits) {
+        r = 1;
+        goto finish;
+    }
+
+    session->count = 0;
+
+    for (uint64_t i = 0; i < session->numRegions && !r; i++) {
+        struct session_region *region = &session->regions[i];
+        struct session_cursor cursor;
+        struct session_set survivors;
+        uint64_t kept = 0;
+        uint64_t j = 0;
+        uint64_t slot;
+        int failed;
+        int more;
+
+        if (region->pages) {
+            r = session_refine_snapshot(session, region, kernel, value, extra, relative, span, hits);
+            session->count += region->set.count;
+            continue;
+        }
+
+        memset(&cursor, NULL, sizeof(cursor));
+        memset(&survivors, NULL, sizeof(survivors));
+
+        more = session_set_next(&region->set, &cursor, &slot);
+        while (more && !r) {
+            uint64_t base = region->start + slot * stride;
+            uint32_t n = 0;
+
+            // take as many candidates as fit into a single read
+            while (more && n < SESSION_BATCH && region->start + slot * stride + length - base <= SESSION_READ_SPAN) {
+                slots[n++] = slot;
+                more = session_set_next(&region->set, &cursor, &slot);
+            }
+
+            if (!n) {
+                // the value alone is bigger than the span
+                slots[n++] = slot;
+                more = session_set_next(&region->set, &cursor, &slot);
+                failed = sys_proc_rw(session->pid, base, current, length, 0);
+            } else {
+                failed = sys_proc_rw(session->pid, base, span, slots[n - 1] * stride + length - (base - region->start), 0);
+                for (uint32_t k = 0; k < n && !failed; k++) {
+                    session_copy(current + k * length, span + (slots[k] - slots[0]) * stride, length);
+                }
+            }
+
+            // candidates that can not be read anymore are dropped
+            if (failed) {
+                j += n;
+                continue;
+            }
+
+            uint32_t count = kernel(current, n * length, length, value,
+                                   relative ? region->values + j * length : extra, relative ? length : 0, length, hits);
+
+            // keep the survivors and remember their current value, the values
+            // are compacted in place since kept never passes j
+            for (uint32_t k = 0; k < count; k++) {
+                if (session_set_add(&survivors, region->slots, slots[hits[k] / length])) {
+                    r = 1;
+                    break;
+                }
+
+                session_copy(region->values + kept * length, current + hits[k], length);
+                kept++;
+            }
+
+            j += n;
+        }
+
+        session_set_free(&region->set);
+        region->set = survivors;
+        session->count += kept;
+    }
+
+    // the regions before the failure are refined already and the values of
+    // the failing one are half compacted, none of it can be trusted anymore
+    if (r) {
+        session_clear(session);
+    } else {
+        session_compact(session);
+    }
+
+finish:
+    if (hits) {
+        free(hits);
+    }
+
+    if (slots) {
+        free(slots);
+    }
+
+    if (current) {
+        free(current);
+    }
+
+    if (span) {
+        free(span);
+    }
+
+    return r;
+}
+
+// copies address and value pairs starting at the index-th candidate into out
+uint64_t session_get_results(struct scan_session *session, uint64_t index, uint64_t count, uint8_t *out) {
+    uint32_t length = session->valueLength;
+    struct session_cursor cursor;
+    uint64_t start = index;
+    uint64_t written = 0;
+    uint64_t region;
+    uint64_t slot;
+
+    if (session->resultsValid && session->resultsIndex == index) {
+        region = session->resultsRegion;
+        cursor = session->resultsCursor;
+    } else {
+        region = 0;
+        while (region < session->numRegions && index >= session_region_count(&session->regions[region])) {
+            index -= session_region_count(&session->regions[region]);
+            region++;
+        }
+
+        memset(&cursor, NULL, sizeof(cursor));
+        if (region < session->numRegions && session->regions[region].pages) {
+            cursor.index = index;
+        }
+
+        while (cursor.index < index && region < session->numRegions) {
+            session_set_next(&session->regions[region].set, &cursor, &slot);
+        }
+    }
+
+    while (written < count && region < session->numRegions) {
+        struct session_region *r = &session->regions[region];
+
+        if (r->pages) {
+            // every slot of a snapshot is a candidate, the value is in the copy
+            if (cursor.index >= r->slots) {
+                memset(&cursor, NULL, sizeof(cursor));
+                region++;
+                continue;
+            }
+
+            slot = cursor.index++;
+
+            uint64_t offset = slot * session->stride;
+            struct session_page *page = &r->pages[offset / PAGE_SIZE];
+            if (page->type == SESSION_PAGE_RAW) {
+                session_copy(out + sizeof(uint64_t), page->data + offset % PAGE_SIZE, length);
+            } else if (page->type == SESSION_PAGE_LZ4) {
+                // results are paged through in order, so the page is expanded
+                // once and kept for the slots after this one
+                if (session->resultsPage != page) {
+                    if (!session->resultsData) {
+                        session->resultsData = (uint8_t *)malloc(PAGE_SIZE);
+                    }
+
+                    if (!session->resultsData || !session_page_data(page, session->resultsData)) {
+                        cursor.index--;
+                        break;
+                    }
+
+                    session->resultsPage = page;
+                }
+
+                session_copy(out + sizeof(uint64_t), session->resultsData + offset % PAGE_SIZE, length);
+            } else {
+                session_copy(out + sizeof(uint64_t), (const uint8_t *)&page->fill + offset % sizeof(uint64_t), length);
+            }
+        } else {
+            if (!session_set_next(&r->set, &cursor, &slot)) {
+                memset(&cursor, NULL, sizeof(cursor));
+                region++;
+                continue;
+            }
+
+            session_copy(out + sizeof(uint64_t), r->values + (cursor.index - 1) * length, length);
+        }
+
+        *(uint64_t *)out = r->start + slot * session->stride;
+        out += sizeof(uint64_t) + length;
+        written++;
+    }
+
+    session->resultsValid = 1;
+    session->resultsIndex = start + written;
+    session->resultsRegion = region;
+    session->resultsCursor = cursor;
+
+    return written;
+}
@@ -0,0 +1,185 @@
+#include "../include/text.h"
+
+static inline uint16_t text_fold_unit(uint16_t unit) {
+    return unit >= 'A' && unit <= 'Z' ? unit + ('a' - 'A') : unit;
+}
+
+// decodes the next UTF-8 sequence, returns its length or 0 when it is invalid
+static uint32_t text_decode(const uint8_t *value, uint32_t length, uint32_t *code) {
+    uint32_t count;
+    uint32_t c = value[0];
+
+    if (c < 0x80) {
+        *code = c;
+        return 1;
+    } else if ((c & 0xE0) == 0xC0) {
+        count = 2;
+        c &= 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        count = 3;
+        c &= 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        count = 4;
+        c &= 0x07;
+    } else {
+        return 0;
+    }
+
+    if (count > length) {
+        return 0;
+    }
+
+    for (uint32_t i = 1; i < count; i++) {
+        if ((value[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+
+        c = (c << 6) | (value[i] & 0x3F);
+    }
+
+    if (c > 0x10FFFF) {
+        return 0;
+    }
+
+    *code = c;
+    return count;
+}
+
+// UTF-8 to UTF-16LE, returns the encoded length or 0
+static uint32_t text_encode_utf16(uint8_t *out, const uint8_t *value, uint32_t length) {
+    uint32_t written = 0;
+
+    for (uint32_t pos = 0; pos < length; ) {
+        uint16_t units[2];
+        uint32_t numUnits = 1;
+        uint32_t code;
+        uint32_t n;
+
+        n = text_decode(value + pos, length - pos, &code);
+        if (!n) {
+            return 0;
+        }
+
+        pos += n;
+
+        if (code >= 0x10000) {
+            code -= 0x10000;
+            units[0] = 0xD800 | (code >> 10);
+            units[1] = 0xDC00 | (code & 0x3FF);
+            numUnits = 2;
+        } else {
+            units[0] = code;
+        }
+
+        if (written + numUnits * 2 > TEXT_MAX_LENGTH) {
+            return 0;
+        }
+
+        for (uint32_t i = 0; i < numUnits; i++) {
+            out[written++] = units[i] & 0xFF;
+            out[written++] = units[i] >> 8;
+        }
+    }
+
+    return written;
+}
+
+int text_compile(struct text_pattern *text, const uint8_t *value, uint32_t length, uint8_t flags) {
+    uint32_t last;
+
+    memset(text, NULL, sizeof(struct text_pattern));
+
+    if (!length) {
+        return 1;
+    }
+
+    if (flags & SCAN_FLAG_UTF16) {
+        text->unit = 2;
+        text->length = text_encode_utf16(text->bytes, value, length);
+    } else {
+        if (length > TEXT_MAX_LENGTH) {
+            return 1;
+        }
+
+        text->unit = 1;
+        text->length = length;
+        memcpy(text->bytes, value, length);
+    }
+
+    if (!text->length) {
+        return 1;
+    }
+
+    text->nocase = (flags & SCAN_FLAG_NOCASE) != 0;
+    for (uint32_t i = 0; i < 256; i++) {
+        text->fold[i] = text->nocase ? text_fold_unit(i) : i;
+    }
+
+    if (text->unit == 2) {
+        for (uint32_t i = 0; i < text->length / 2; i++) {
+            text->units[i] = text_fold_unit(text->bytes[i * 2] | (text->bytes[i * 2 + 1] << 8));
+        }
+    }
+
+    for (uint32_t i = 0; i < text->length; i++) {
+        text->bytes[i] = text->fold[text->bytes[i]];
+    }
+
+    last = text->length - 1;
+    for (uint32_t i = 0; i < 256; i++) {
+        text->shift[i] = text->length;
+    }
+
+    for (uint32_t i = 0; i < last; i++) {
+        text->shift[text->bytes[i]] = last - i;
+    }
+
+    return 0;
+}
+
+// folding the bytes of an UTF-16 unit one by one also folds the low byte of
+// characters that are not letters, so those candidates are checked per unit
+static int text_units_match(const struct text_pattern *text, const uint8_t *memory) {
+    for (uint32_t i = 0; i < text->length / 2; i++) {
+        if (text_fold_unit(memory[i * 2] | (memory[i * 2 + 1] << 8)) != text->units[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+uint32_t text_kernel(const uint8_t *memory, uint32_t length, uint32_t stride,
+                     const uint8_t *value, const uint8_t *extra, uint32_t extraStride,
+                     uint32_t valueLength, uint32_t *hits) {
+    const struct text_pattern *text = (const struct text_pattern *)value;
+    const uint8_t *fold = text->fold;
+    uint32_t last = text->length - 1;
+    uint8_t tail = text->bytes[last];
+    uint32_t count = 0;
+
+    if (length < text->length) {
+        return 0;
+    }
+
+    // the last character is the prefilter, most positions are skipped by the
+    // shift without looking at anything else
+    for (uint32_t pos = 0; pos <= length - text->length; ) {
+        uint8_t c = fold[memory[pos + last]];
+
+        if (c == tail && !(pos % stride)) {
+            uint32_t i = 0;
+            while (i < last && fold[memory[pos + i]] == text->bytes[i]) {
+                i++;
+            }
+
+            if (i == last && (text->unit == 1 || !text->nocase || text_units_match(text, memory + pos))) {
+                hits[count++] = pos;
+            }
+        }
+
+        pos += text->shift[c];
+    }
+
+    return count;
+}
@@ -0,0 +1,248 @@
+#include "../include/transfer.h"
+
+static struct transfer_buffer transfers[TRANSFER_MAX];
+
+static struct transfer_buffer *transfer_find(int fd) {
+    for (int i = 0; i < TRANSFER_MAX; i++) {
+        if (transfers[i].fd == fd) {
+            return &transfers[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint8_t *transfer_map(uint32_t size) {
+    uint8_t *data = (uint8_t *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    // not being able to lock it only costs the faults
+    mlock(data, size);
+
+    for (uint32_t i = 0; i < size; i += PAGE_SIZE) {
+        data[i] = 0;
+    }
+
+    return data;
+}
+
+static uint32_t transfer_clamp(uint32_t size) {
+    if (size < TRANSFER_MIN_SIZE) {
+        size = TRANSFER_MIN_SIZE;
+    }
+
+    if (size > TRANSFER_MAX_SIZE) {
+        size = TRANSFER_MAX_SIZE;
+    }
+
+    return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+}
+
+struct transfer_buffer *transfer_get(int fd) {
+    struct transfer_buffer *transfer = transfer_find(fd);
+
+    if (transfer) {
+        return transfer;
+    }
+
+    for (int i = 0; i < TRANSFER_MAX && !transfer; i++) {
+        if (__sync_bool_compare_and_swap(&transfers[i].fd, 0, fd)) {
+            transfer = &transfers[i];
+        }
+    }
+
+    if (!transfer) {
+        return NULL;
+    }
+
+    transfer->size = transfer_clamp(TRANSFER_DEFAULT_SIZE);
+    transfer->data = transfer_map(transfer->size);
+    if (!transfer->data) {
+        transfer_free(fd);
+        return NULL;
+    }
+
+    return transfer;
+}
+
+uint32_t transfer_resize(int fd, uint32_t size) {
+    struct transfer_buffer *transfer = transfer_get(fd);
+    uint8_t *data;
+    uint8_t *packed = NULL;
+
+    if (!transfer) {
+        return 0;
+    }
+
+    size = transfer_clamp(size);
+    if (size == transfer->size) {
+        return size;
+    }
+
+    data = transfer_map(size);
+    if (transfer->packed) {
+        packed = transfer_map(size);
+    }
+
+    if (!data || (transfer->packed && !packed)) {
+        if (data) {
+            munmap(data, size);
+        }
+
+        if (packed) {
+            munmap(packed, size);
+        }
+
+        return transfer->size;
+    }
+
+    munmap(transfer->data, transfer->size);
+    transfer->data = data;
+
+    if (packed) {
+        munmap(transfer->packed, transfer->size);
+        transfer->packed = packed;
+    }
+
+    transfer->size = size;
+
+    return size;
+}
+
+uint32_t transfer_set_flags(int fd, uint32_t flags) {
+    struct transfer_buffer *transfer = transfer_get(fd);
+
+    if (!transfer) {
+        return 0;
+    }
+
+    // the compression buffers stay once they are there, a half set up pair
+    // is dropped so the next call starts over
+    if ((flags & TRANSFER_FLAG_LZ4) && !transfer->packed) {
+        transfer->table = (uint32_t *)malloc(LZ4_TABLE_SIZE);
+        transfer->packed = transfer_map(transfer->size);
+        if (!transfer->table || !transfer->packed) {
+            if (transfer->table) {
+                free(transfer->table);
+            }
+
+            if (transfer->packed) {
+                munmap(transfer->packed, transfer->size);
+            }
+
+            transfer->table = NULL;
+            transfer->packed = NULL;
+            flags &= ~TRANSFER_FLAG_LZ4;
+        }
+    }
+
+    transfer->flags = flags & TRANSFER_FLAG_LZ4;
+
+    return transfer->flags;
+}
+
+void transfer_free(int fd) {
+    struct transfer_buffer *transfer = transfer_find(fd);
+    if (!transfer) {
+        return;
+    }
+
+    if (transfer->data) {
+        munmap(transfer->data, transfer->size);
+    }
+
+    if (transfer->packed) {
+        munmap(transfer->packed, transfer->size);
+    }
+
+    if (transfer->table) {
+        free(transfer->table);
+    }
+
+    memset(transfer, NULL, sizeof(struct transfer_buffer));
+}
+
+int transfer_send(int fd, struct transfer_buffer *transfer, const uint8_t *data, uint32_t length) {
+    struct cmd_proc_transfer_block block;
+
+    if (!(transfer->flags & TRANSFER_FLAG_LZ4)) {
+        return net_send_block(fd, (void *)data, length) != length;
+    }
+
+    while (length) {
+        uint8_t *packed = transfer->packed + CMD_PROC_TRANSFER_BLOCK_SIZE;
+        uint32_t capacity;
+
+        block.rawLength = length > transfer->size ? transfer->size : length;
+
+        // only worth it when it comes out smaller, otherwise the block is raw,
+        // a compressed block is written behind its header and goes out whole
+        capacity = block.rawLength - 1;
+        if (capacity > transfer->size - CMD_PROC_TRANSFER_BLOCK_SIZE) {
+            capacity = transfer->size - CMD_PROC_TRANSFER_BLOCK_SIZE;
+        }
+
+        block.length = lz4_compress(data, block.rawLength, packed, capacity, transfer->table);
+        if (block.length) {
+            memcpy(transfer->packed, &block, CMD_PROC_TRANSFER_BLOCK_SIZE);
+
+            if (net_send_block(fd, transfer->packed, CMD_PROC_TRANSFER_BLOCK_SIZE + block.length) != CMD_PROC_TRANSFER_BLOCK_SIZE + block.length) {
+                return 1;
+            }
+        } else {
+            block.length = block.rawLength;
+
+            if (net_send_data(fd, &block, CMD_PROC_TRANSFER_BLOCK_SIZE) != CMD_PROC_TRANSFER_BLOCK_SIZE) {
+                return 1;
+            }
+
+            if (net_send_block(fd, (void *)data, block.length) != block.length) {
+                return 1;
+            }
+        }
+
+        data += block.rawLength;
+        length -= block.rawLength;
+    }
+
+    return 0;
+}
+
+int transfer_recv(int fd, struct transfer_buffer *transfer, uint8_t *data, uint32_t length) {
+    struct cmd_proc_transfer_block block;
+
+    if (!(transfer->flags & TRANSFER_FLAG_LZ4)) {
+        return net_recv_data(fd, data, length, 1) != length;
+    }
+
+    while (length) {
+        if (net_recv_data(fd, &block, CMD_PROC_TRANSFER_BLOCK_SIZE, 1) != CMD_PROC_TRANSFER_BLOCK_SIZE) {
+            return 1;
+        }
+
+        if (!block.rawLength || block.rawLength > length || block.rawLength > transfer->size || block.length > block.rawLength) {
+            return 1;
+        }
+
+        if (block.length == block.rawLength) {
+            if (net_recv_data(fd, data, block.length, 1) != block.length) {
+                return 1;
+            }
+        } else {
+            if (net_recv_data(fd, transfer->packed, block.length, 1) != block.length) {
+                return 1;
+            }
+
+            if (lz4_decompress(transfer->packed, block.length, data, block.rawLength)) {
+                return 1;
+            }
+        }
+
+        data += block.rawLength;
+        length -= block.rawLength;
+    }
+
+    return 0;
+}
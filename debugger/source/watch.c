@@ -0,0 +1,248 @@
+#include "../include/watch.h"
+#include "../include/server.h"
+
+static struct watch_set watches[WATCH_MAX];
+
+static struct watch_set *watch_find(int fd) {
+    for (int i = 0; i < WATCH_MAX; i++) {
+        if (watches[i].fd == fd) {
+            return &watches[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int watch_connect(int fd) {
+    struct sockaddr_in server;
+    struct server_client *svc = NULL;
+    int sock;
+
+    for (int i = 0; i < SERVER_MAXCLIENTS; i++) {
+        if (servclients[i].id && servclients[i].fd == fd) {
+            svc = &servclients[i];
+            break;
+        }
+    }
+
+    if (!svc) {
+        return -1;
+    }
+
+    server.sin_len = sizeof(server);
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = svc->client.sin_addr.s_addr;
+    server.sin_port = sceNetHtons(WATCH_PORT);
+    memset(server.sin_zero, NULL, sizeof(server.sin_zero));
+
+    sock = sceNetSocket("watch", AF_INET, SOCK_STREAM, 0);
+    if (sock <= 0) {
+        return -1;
+    }
+
+    if (sceNetConnect(sock, (struct sockaddr *)&server, sizeof(server))) {
+        sceNetSocketClose(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+// samples the entries that are due, returns the bytes of the frame
+static uint32_t watch_sample(struct watch_set *set, uint64_t now, uint32_t *count, uint64_t *next) {
+    uint8_t value[WATCH_MAX_LENGTH];
+    uint32_t length = sizeof(struct cmd_proc_watch_frame);
+
+    for (uint32_t i = 0; i < set->count; i++) {
+        struct watch_entry *entry = &set->entries[i];
+        struct cmd_proc_watch_value *out;
+        int state;
+
+        if (entry->due <= now) {
+            // a late round does not make up for the samples it missed
+            entry->due = now + entry->interval;
+
+            state = sys_proc_rw(entry->pid, entry->address, value, entry->length, 0) ? 2 : 1;
+
+            if (state != entry->state || (state == 1 && memcmp(value, entry->last, entry->length))) {
+                out = (struct cmd_proc_watch_value *)(set->frame + length);
+                out->index = i;
+                out->length = state == 1 ? entry->length : 0;
+                length += sizeof(struct cmd_proc_watch_value);
+
+                if (state == 1) {
+                    memcpy(entry->last, value, entry->length);
+                    memcpy(set->frame + length, value, entry->length);
+                    length += entry->length;
+                }
+
+                entry->state = state;
+                (*count)++;
+            }
+        }
+
+        if (entry->due < *next) {
+            *next = entry->due;
+        }
+    }
+
+    return length;
+}
+
+static void *watch_thread(void *arg) {
+    struct watch_set *set = (struct watch_set *)arg;
+
+    while (!set->stop) {
+        struct cmd_proc_watch_frame *frame = (struct cmd_proc_watch_frame *)set->frame;
+        uint64_t now = sceKernelGetProcessTime();
+        uint64_t next = now + WATCH_IDLE;
+        uint32_t count = 0;
+        uint32_t length;
+
+        length = watch_sample(set, now, &count, &next);
+
+        if (count) {
+            frame->time = now;
+            frame->count = count;
+            frame->length = length - sizeof(struct cmd_proc_watch_frame);
+
+            // the client stopped listening, the next update connects again
+            if (net_send_data(set->sock, set->frame, length) != length) {
+                set->failed = 1;
+                break;
+            }
+        }
+
+        now = sceKernelGetProcessTime();
+        if (next > now) {
+            sceKernelUsleep(next - now);
+        } else {
+            scePthreadYield();
+        }
+    }
+
+    return NULL;
+}
+
+static void watch_stop(struct watch_set *set) {
+    if (set->started) {
+        set->stop = 1;
+        scePthreadJoin(set->thread, NULL);
+        set->started = 0;
+        set->stop = 0;
+    }
+
+    if (set->entries) {
+        free(set->entries);
+    }
+
+    if (set->values) {
+        free(set->values);
+    }
+
+    if (set->frame) {
+        free(set->frame);
+    }
+
+    set->entries = NULL;
+    set->values = NULL;
+    set->frame = NULL;
+    set->count = 0;
+}
+
+int watch_update(int fd, struct cmd_proc_watch_entry *entries, uint32_t count) {
+    struct watch_set *set;
+    uint64_t valuesLength = 0;
+    uint64_t now;
+
+    if (!count) {
+        watch_free(fd);
+        return 0;
+    }
+
+    set = watch_find(fd);
+    if (set) {
+        watch_stop(set);
+    } else {
+        for (int i = 0; i < WATCH_MAX && !set; i++) {
+            if (__sync_bool_compare_and_swap(&watches[i].fd, 0, fd)) {
+                set = &watches[i];
+            }
+        }
+
+        if (!set) {
+            return 1;
+        }
+    }
+
+    if (set->failed) {
+        sceNetSocketClose(set->sock);
+        set->sock = 0;
+        set->failed = 0;
+    }
+
+    if (!set->sock) {
+        set->sock = watch_connect(fd);
+        if (set->sock < 0) {
+            set->sock = 0;
+            watch_free(fd);
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        valuesLength += entries[i].length;
+    }
+
+    set->entries = (struct watch_entry *)malloc(count * sizeof(struct watch_entry));
+    set->values = (uint8_t *)malloc(valuesLength ? valuesLength : 1);
+    set->frame = (uint8_t *)pfmalloc(sizeof(struct cmd_proc_watch_frame) + count * sizeof(struct cmd_proc_watch_value) + valuesLength);
+    if (!set->entries || !set->values || !set->frame) {
+        watch_free(fd);
+        return 1;
+    }
+
+    // everything is sampled right away so the client gets the current values
+    now = sceKernelGetProcessTime();
+    valuesLength = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        struct watch_entry *entry = &set->entries[i];
+        uint32_t interval = entries[i].interval < WATCH_MIN_INTERVAL ? WATCH_MIN_INTERVAL : entries[i].interval;
+
+        entry->pid = entries[i].pid;
+        entry->address = entries[i].address;
+        entry->length = entries[i].length;
+        entry->interval = interval * 1000ull;
+        entry->due = now;
+        entry->state = 0;
+        entry->last = set->values + valuesLength;
+
+        valuesLength += entry->length;
+    }
+
+    set->count = count;
+
+    if (scePthreadCreate(&set->thread, NULL, watch_thread, set, "watch")) {
+        watch_free(fd);
+        return 1;
+    }
+
+    set->started = 1;
+
+    return 0;
+}
+
+void watch_free(int fd) {
+    struct watch_set *set = watch_find(fd);
+    if (!set) {
+        return;
+    }
+
+    watch_stop(set);
+
+    if (set->sock) {
+        sceNetSocketClose(set->sock);
+    }
+
+    memset(set, NULL, sizeof(struct watch_set));
+}
@@ -41,6 +41,8 @@ int sys_proc_rw(struct thread *td, struct sys_proc_rw_args *uap);
 #define SYS_PROC_ELF        7
 #define SYS_PROC_INFO       8
 #define SYS_PROC_THRINFO    9
+#define SYS_PROC_SCAN       10
+#define SYS_PROC_WRITE_V    11
 struct sys_proc_alloc_args {
     uint64_t address;
     uint64_t length;
@@ -88,6 +90,46 @@ struct sys_proc_thrinfo_args {
     uint32_t priority;
     char name[32];
 } __attribute__((packed));
+// value and compare types use the same numbers as the debugger protocol,
+// only the integer values and the compares against a fixed value are done here
+#define SYS_PROC_SCAN_U8        0
+#define SYS_PROC_SCAN_S8        1
+#define SYS_PROC_SCAN_U16       2
+#define SYS_PROC_SCAN_S16       3
+#define SYS_PROC_SCAN_U32       4
+#define SYS_PROC_SCAN_S32       5
+#define SYS_PROC_SCAN_U64       6
+#define SYS_PROC_SCAN_S64       7
+#define SYS_PROC_SCAN_EXACT     0
+#define SYS_PROC_SCAN_BIGGER    2
+#define SYS_PROC_SCAN_LESS      3
+#define SYS_PROC_SCAN_BETWEEN   4
+#define SYS_PROC_SCAN_PIECE     0x10000 // bytes read and compared at a time
+struct sys_proc_scan_args {
+    uint64_t address;
+    uint64_t length;        // bytes that may be read
+    uint64_t limit;         // values have to start below address + limit
+    uint32_t valueType;
+    uint32_t compareType;
+    uint8_t value[8];
+    uint8_t extra[8];       // upper bound of between
+    uint32_t stride;
+    uint8_t *data;          // each hit value is written at its own offset
+    uint32_t *hits;         // offsets from address
+    uint32_t maxHits;
+    uint32_t count;
+} __attribute__((packed));
+// every entry is written, failed counts the ones that could not be
+struct sys_proc_write_v_entry {
+    uint64_t address;
+    uint8_t *data;
+    uint32_t length;
+} __attribute__((packed));
+struct sys_proc_write_v_args {
+    struct sys_proc_write_v_entry *entries;
+    uint32_t count;
+    uint32_t failed;
+} __attribute__((packed));
 struct sys_proc_cmd_args {
     uint64_t pid;
     uint64_t cmd;
@@ -254,6 +254,151 @@ int sys_proc_thrinfo_handle(struct proc *p, struct sys_proc_thrinfo_args *args)
     return 1;
 }
 
+// Compares the values of a piece that was read into buffer, pos is where the
+// piece starts. Only the matching values leave the kernel. There is one loop
+// per type and compare, nothing is decided per value.
+typedef int (*sys_proc_scan_compare_t)(struct sys_proc_scan_args *args, uint8_t *buffer, uint64_t pos, uint64_t n, uint64_t read);
+
+#define SYS_PROC_SCAN_LOOP(name, type, condition) \
+static int name(struct sys_proc_scan_args *args, uint8_t *buffer, uint64_t pos, uint64_t n, uint64_t read) { \
+    type v = *(type *)args->value; \
+    type x = *(type *)args->extra; \
+    type lo = x > v ? v : x; \
+    type hi = x > v ? x : v; \
+    uint32_t stride = args->stride; \
+    uint32_t count = args->count; \
+    (void)lo; \
+    (void)hi; \
+    if (n > read - sizeof(type) + 1) { \
+        n = read - sizeof(type) + 1; \
+    } \
+    for (uint64_t off = 0; off < n; off += stride) { \
+        type m = *(type *)(buffer + off); \
+        if (condition) { \
+            if (count == args->maxHits) { \
+                args->count = count; \
+                return 1; \
+            } \
+            args->hits[count++] = pos + off; \
+            *(type *)(args->data + pos + off) = m; \
+        } \
+    } \
+    args->count = count; \
+    return 0; \
+}
+
+#define SYS_PROC_SCAN_LOOPS(suffix, type) \
+SYS_PROC_SCAN_LOOP(sys_proc_scan_exact_##suffix, type, m == v) \
+SYS_PROC_SCAN_LOOP(sys_proc_scan_bigger_##suffix, type, m > v) \
+SYS_PROC_SCAN_LOOP(sys_proc_scan_less_##suffix, type, m < v) \
+SYS_PROC_SCAN_LOOP(sys_proc_scan_between_##suffix, type, m > lo && m < hi)
+
+SYS_PROC_SCAN_LOOPS(u8, uint8_t)
+SYS_PROC_SCAN_LOOPS(s8, int8_t)
+SYS_PROC_SCAN_LOOPS(u16, uint16_t)
+SYS_PROC_SCAN_LOOPS(s16, int16_t)
+SYS_PROC_SCAN_LOOPS(u32, uint32_t)
+SYS_PROC_SCAN_LOOPS(s32, int32_t)
+SYS_PROC_SCAN_LOOPS(u64, uint64_t)
+SYS_PROC_SCAN_LOOPS(s64, int64_t)
+
+#define SYS_PROC_SCAN_ROW(suffix) { \
+    [SYS_PROC_SCAN_EXACT] = sys_proc_scan_exact_##suffix, \
+    [SYS_PROC_SCAN_BIGGER] = sys_proc_scan_bigger_##suffix, \
+    [SYS_PROC_SCAN_LESS] = sys_proc_scan_less_##suffix, \
+    [SYS_PROC_SCAN_BETWEEN] = sys_proc_scan_between_##suffix, \
+}
+
+static const sys_proc_scan_compare_t sys_proc_scan_loops[SYS_PROC_SCAN_S64 + 1][SYS_PROC_SCAN_BETWEEN + 1] = {
+    [SYS_PROC_SCAN_U8] = SYS_PROC_SCAN_ROW(u8),
+    [SYS_PROC_SCAN_S8] = SYS_PROC_SCAN_ROW(s8),
+    [SYS_PROC_SCAN_U16] = SYS_PROC_SCAN_ROW(u16),
+    [SYS_PROC_SCAN_S16] = SYS_PROC_SCAN_ROW(s16),
+    [SYS_PROC_SCAN_U32] = SYS_PROC_SCAN_ROW(u32),
+    [SYS_PROC_SCAN_S32] = SYS_PROC_SCAN_ROW(s32),
+    [SYS_PROC_SCAN_U64] = SYS_PROC_SCAN_ROW(u64),
+    [SYS_PROC_SCAN_S64] = SYS_PROC_SCAN_ROW(s64),
+};
+
+int sys_proc_scan_handle(struct proc *p, struct sys_proc_scan_args *args) {
+    sys_proc_scan_compare_t compare;
+    uint64_t size;
+    uint64_t piece;
+    uint8_t *buffer;
+    int r;
+
+    if(args->valueType > SYS_PROC_SCAN_S64 || args->compareType > SYS_PROC_SCAN_BETWEEN) {
+        return 1;
+    }
+
+    compare = sys_proc_scan_loops[args->valueType][args->compareType];
+    if(!compare) {
+        return 1;
+    }
+
+    // u8/s8 are 0/1, u16/s16 2/3 and so on
+    size = 1ull << (args->valueType / 2);
+
+    if(!args->stride || !args->data || !args->hits || args->limit > args->length) {
+        return 1;
+    }
+
+    // one proc_rw_mem per piece, a piece is a multiple of the stride so
+    // every piece starts on a value
+    piece = SYS_PROC_SCAN_PIECE - (SYS_PROC_SCAN_PIECE % args->stride);
+    if(!piece) {
+        piece = args->stride;
+    }
+
+    buffer = (uint8_t *)malloc(piece + size, M_TEMP, 2);
+    if(!buffer) {
+        return 1;
+    }
+
+    args->count = 0;
+
+    r = 0;
+    for(uint64_t pos = 0; pos < args->limit && !r; pos += piece) {
+        uint64_t n = args->limit - pos > piece ? piece : args->limit - pos;
+        uint64_t read = n + size - 1;
+        if(read > args->length - pos) {
+            read = args->length - pos;
+        }
+
+        // a value that does not fit has nothing left to compare
+        if(read < size) {
+            break;
+        }
+
+        r = proc_rw_mem(p, (void *)(args->address + pos), read, buffer, 0, 0);
+        if(!r) {
+            r = compare(args, buffer, pos, n, read);
+        }
+    }
+
+    free(buffer, M_TEMP);
+
+    return r;
+}
+
+int sys_proc_write_v_handle(struct proc *p, struct sys_proc_write_v_args *args) {
+    if(!args->entries) {
+        return 1;
+    }
+
+    args->failed = 0;
+
+    for(uint32_t i = 0; i < args->count; i++) {
+        struct sys_proc_write_v_entry *entry = &args->entries[i];
+
+        if(proc_rw_mem(p, (void *)entry->address, entry->length, entry->data, 0, 1)) {
+            args->failed++;
+        }
+    }
+
+    return 0;
+}
+
 int sys_proc_cmd(struct thread *td, struct sys_proc_cmd_args *uap) {
     struct proc *p;
     int r;
@@ -292,6 +437,12 @@ int sys_proc_cmd(struct thread *td, struct sys_proc_cmd_args *uap) {
         case SYS_PROC_THRINFO:
             r = sys_proc_thrinfo_handle(p, (struct sys_proc_thrinfo_args *)uap->data);
             break;
+        case SYS_PROC_SCAN:
+            r = sys_proc_scan_handle(p, (struct sys_proc_scan_args *)uap->data);
+            break;
+        case SYS_PROC_WRITE_V:
+            r = sys_proc_write_v_handle(p, (struct sys_proc_write_v_args *)uap->data);
+            break;
         default:
             r = 1;
             break;